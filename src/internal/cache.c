@@ -0,0 +1,188 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/cache.c
+ * @authors Charles Faisandier
+ * @brief CM7 L1 cache and MPU configuration.
+ */
+
+#include "cache.h"
+#include "mmio.h"
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+
+// MPU region numbers. Where regions overlap, the higher number wins.
+#define MPU_REGION_PERIPH 0U
+#define MPU_REGION_AXI_SRAM 1U
+#define MPU_REGION_DMA_BUFFER 2U
+#define MPU_REGION_SRAM4 3U
+
+// Region bases and sizes (log2 of the size in bytes).
+#define PERIPH_BASE 0x40000000U
+#define PERIPH_SIZE_LOG2 29U
+#define AXI_SRAM_BASE 0x24000000U
+#define AXI_SRAM_SIZE_LOG2 19U
+#define SRAM4_BASE 0x38000000U
+#define SRAM4_SIZE_LOG2 16U
+
+// Full access from privileged and unprivileged code.
+#define MPU_AP_FULL 3U
+
+// Region attributes (TEX, C, B and S encodings from the ARMv7-M memory model).
+#define MPU_ATTR_DEVICE                                                                \
+  (TO_FIELD(0U, MPU_MPU_RASR_TEX) | MPU_MPU_RASR_B.msk | MPU_MPU_RASR_S.msk |          \
+   MPU_MPU_RASR_XN.msk)
+#define MPU_ATTR_WRITE_THROUGH (TO_FIELD(0U, MPU_MPU_RASR_TEX) | MPU_MPU_RASR_C.msk)
+#define MPU_ATTR_NON_CACHEABLE (TO_FIELD(1U, MPU_MPU_RASR_TEX) | MPU_MPU_RASR_S.msk)
+
+// DMA buffer region, from the linker script. The size symbol's address is its value.
+extern uint32_t __dma_buffer_start[];
+extern uint32_t __DMA_BUFFER_SIZE[];
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+
+static inline void cache_dsb(void) {
+  __asm__ volatile ("dsb" ::: "memory");
+}
+
+static inline void cache_dsb_isb(void) {
+  __asm__ volatile ("dsb\n\tisb" ::: "memory");
+}
+
+static void mpu_set_region(uint32_t region, uint32_t base, uint32_t size_log2, uint32_t attr) {
+  *MPU_MPU_RNR = region;
+  *MPU_MPU_RBAR = base & MPU_MPU_RBAR_ADDR.msk;
+  *MPU_MPU_RASR = attr | TO_FIELD(MPU_AP_FULL, MPU_MPU_RASR_AP) |
+                  TO_FIELD(size_log2 - 1U, MPU_MPU_RASR_SIZE) | MPU_MPU_RASR_ENABLE.msk;
+}
+
+static void mpu_init(void) {
+  cache_dsb();
+  CLR_FIELD(MPU_MPU_CTRL, MPU_MPU_CTRL_ENABLE);
+
+  uint32_t dma_size = (uint32_t)(uintptr_t)__DMA_BUFFER_SIZE;
+  mpu_set_region(MPU_REGION_PERIPH, PERIPH_BASE, PERIPH_SIZE_LOG2, MPU_ATTR_DEVICE);
+  mpu_set_region(MPU_REGION_AXI_SRAM, AXI_SRAM_BASE, AXI_SRAM_SIZE_LOG2,
+                 MPU_ATTR_WRITE_THROUGH);
+  mpu_set_region(MPU_REGION_DMA_BUFFER, (uint32_t)(uintptr_t)__dma_buffer_start,
+                 (uint32_t)__builtin_ctz(dma_size), MPU_ATTR_NON_CACHEABLE);
+  mpu_set_region(MPU_REGION_SRAM4, SRAM4_BASE, SRAM4_SIZE_LOG2, MPU_ATTR_NON_CACHEABLE);
+
+  // Everything not covered by a region keeps the default memory map.
+  *MPU_MPU_CTRL = MPU_MPU_CTRL_ENABLE.msk | MPU_MPU_CTRL_PRIVDEFENA.msk;
+  cache_dsb_isb();
+}
+
+// Runs a set/way maintenance operation over the whole L1 data cache.
+static void dcache_set_way_op(rw_reg32_t op) {
+  *SCB_CSSELR = 0U; // Level 1 data cache
+  cache_dsb();
+  uint32_t ccsidr = *SCB_CCSIDR;
+  uint32_t sets = ((ccsidr & SCB_CCSIDR_NUMSETS.msk) >> SCB_CCSIDR_NUMSETS.pos) + 1U;
+  uint32_t ways = ((ccsidr & SCB_CCSIDR_ASSOCIATIVITY.msk) >> SCB_CCSIDR_ASSOCIATIVITY.pos) + 1U;
+  uint32_t set_shift = ((ccsidr & SCB_CCSIDR_LINESIZE.msk) >> SCB_CCSIDR_LINESIZE.pos) + 4U;
+  uint32_t way_shift = (uint32_t)__builtin_clz(ways - 1U);
+  for (uint32_t set = 0; set < sets; set++) {
+    for (uint32_t way = 0; way < ways; way++) {
+      *op = (way << way_shift) | (set << set_shift);
+    }
+  }
+  cache_dsb_isb();
+}
+
+// Runs a by-address maintenance operation over every line touching a range.
+static void dcache_range_op(rw_reg32_t op, uintptr_t addr, size_t size) {
+  if (size == 0U || !cache_dcache_enabled()) {
+    return;
+  }
+  uintptr_t line = addr & ~(uintptr_t)(CACHE_LINE_SIZE - 1U);
+  uintptr_t end = addr + size;
+  cache_dsb();
+  for (; line < end; line += CACHE_LINE_SIZE) {
+    *op = (uint32_t)line;
+  }
+  cache_dsb_isb();
+}
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+
+void cache_init(void) {
+  mpu_init();
+
+  if (!IS_FIELD_SET(SCB_CCR, SCB_CCR_IC)) {
+    cache_dsb_isb();
+    *SCB_ICIALLU = 0U;
+    cache_dsb_isb();
+    SET_FIELD(SCB_CCR, SCB_CCR_IC);
+    cache_dsb_isb();
+  }
+
+#ifdef TI_DCACHE
+  // The cache holds random contents after reset, so it is invalidated before use.
+  if (!cache_dcache_enabled()) {
+    dcache_set_way_op(SCB_DCISW);
+    SET_FIELD(SCB_CCR, SCB_CCR_DC);
+    cache_dsb_isb();
+  }
+#endif
+}
+
+bool cache_dcache_enabled(void) {
+  return IS_FIELD_SET(SCB_CCR, SCB_CCR_DC);
+}
+
+void cache_clean(const void *addr, size_t size) {
+  dcache_range_op(SCB_DCCMVAC, (uintptr_t)addr, size);
+}
+
+void cache_invalidate(void *addr, size_t size) {
+  dcache_range_op(SCB_DCIMVAC, (uintptr_t)addr, size);
+}
+
+void cache_invalidate_dma(void *addr, size_t size) {
+  uintptr_t start = (uintptr_t)addr;
+  uintptr_t end = start + size;
+  uintptr_t mask = CACHE_LINE_SIZE - 1U;
+  uintptr_t first_whole = (start + mask) & ~mask;
+  uintptr_t last_whole = end & ~mask;
+  if (first_whole >= last_whole) {
+    dcache_range_op(SCB_DCCIMVAC, start, size);
+    return;
+  }
+  if (start != first_whole) {
+    dcache_range_op(SCB_DCCIMVAC, start, 1U);
+  }
+  dcache_range_op(SCB_DCIMVAC, first_whole, last_whole - first_whole);
+  if (end != last_whole) {
+    dcache_range_op(SCB_DCCIMVAC, last_whole, 1U);
+  }
+}
+
+void cache_clean_invalidate(void *addr, size_t size) {
+  dcache_range_op(SCB_DCCIMVAC, (uintptr_t)addr, size);
+}
+
+void cache_clean_invalidate_all(void) {
+  if (cache_dcache_enabled()) {
+    dcache_set_way_op(SCB_DCCISW);
+  }
+}
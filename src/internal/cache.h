@@ -0,0 +1,100 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/cache.h
+ * @authors Charles Faisandier
+ * @brief CM7 L1 cache and MPU configuration.
+ *
+ * cache_init() programs the MPU and enables the caches. The MPU regions are:
+ * - Peripherals (0x40000000, 512 MiB): device memory, never executed.
+ * - AXI SRAM: write-through, so DMA reads never see stale data.
+ * - DMA buffers (TI_DMA_BUFFER, in SRAM1/2): non-cacheable, so no maintenance is needed.
+ * - SRAM4: non-cacheable, so data shared with the CM4 (TI_SHARED) is always coherent.
+ * All other memory uses the default memory map (SRAM write-back, TCMs uncached).
+ *
+ * Buffers in cacheable memory that are handed to a DMA controller must be maintained with the
+ * functions below. The DMA driver does this for every transfer it runs. Receive buffers should
+ * be aligned to CACHE_LINE_SIZE and a whole number of lines long; otherwise the CPU must not
+ * write the data sharing their first and last lines while the transfer runs, or the received
+ * bytes in those lines may be stale.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+
+/** @brief CM7 L1 cache line size in bytes. */
+#define CACHE_LINE_SIZE 32U
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+
+/**
+ * @brief Programs the MPU regions and enables the instruction cache, and the data cache when
+ *        TI_DCACHE is defined.
+ * @note - Called from the CM7 reset handler before any section is loaded, so it must not rely
+ *         on initialized data.
+ */
+void cache_init(void);
+
+/**
+ * @brief Checks whether the data cache is enabled.
+ * @returns (bool) True if the data cache is enabled.
+ */
+bool cache_dcache_enabled(void);
+
+/**
+ * @brief Writes dirty lines covering a range back to memory, so a DMA read sees the CPU's data.
+ * @param addr (const void*) Start of the range.
+ * @param size (size_t) Size of the range in bytes.
+ */
+void cache_clean(const void *addr, size_t size);
+
+/**
+ * @brief Discards the lines covering a range, so the CPU reads what a DMA write left in memory.
+ * @param addr (void*) Start of the range.
+ * @param size (size_t) Size of the range in bytes.
+ * @note - Data written by the CPU to the partial lines at either end of the range is lost.
+ */
+void cache_invalidate(void *addr, size_t size);
+
+/**
+ * @brief Discards the lines covering a buffer a DMA has just written. The partial lines at
+ *        either end are written back before being discarded, so CPU data sharing them with
+ *        the buffer is kept.
+ * @param addr (void*) Start of the buffer.
+ * @param size (size_t) Size of the buffer in bytes.
+ */
+void cache_invalidate_dma(void *addr, size_t size);
+
+/**
+ * @brief Writes back and then discards the lines covering a range.
+ * @param addr (void*) Start of the range.
+ * @param size (size_t) Size of the range in bytes.
+ */
+void cache_clean_invalidate(void *addr, size_t size);
+
+/**
+ * @brief Writes back and discards the whole data cache. Cheaper than cache_clean_invalidate()
+ *        for ranges larger than the cache.
+ */
+void cache_clean_invalidate_all(void);
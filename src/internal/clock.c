@@ -0,0 +1,561 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/clock.c
+ * @authors Charles Faisandier
+ * @brief RCC clock tree configuration and clock frequency queries.
+ */
+
+#include "clock.h"
+#include "mmio.h"
+#include <stddef.h>
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+
+// Polls allowed for an oscillator, PLL, regulator or clock switch to become ready.
+#define CLOCK_TIMEOUT 1000000U
+
+// RCC_CFGR SW/SWS value selecting PLL1 P. Lower values follow clock_source_t.
+#define CLOCK_SW_PLL1 3U
+
+// Input range of the HSE, and of the PLL reference after the M divider.
+#define HSE_MIN_HZ 4000000U
+#define HSE_MAX_HZ 50000000U
+#define PLL_REF_MIN_HZ 1000000U
+#define PLL_REF_MAX_HZ 16000000U
+
+// Wide VCO range, for references of 2 MHz and up. Lower references need the medium VCO.
+#define PLL_WIDE_REF_MIN_HZ 2000000U
+#define PLL_WIDE_VCO_MIN_HZ 192000000U
+#define PLL_WIDE_VCO_MAX_HZ 960000000U
+#define PLL_MEDIUM_VCO_MIN_HZ 150000000U
+#define PLL_MEDIUM_VCO_MAX_HZ 420000000U
+
+// Divider ranges.
+#define PLL_M_MAX 63U
+#define PLL_N_MIN 4U
+#define PLL_N_MAX 512U
+#define PLL_DIV_MAX 128U
+
+// Fixed output of clock_config_480mhz(): a 960 MHz VCO divided by 2.
+#define PRESET_VCO_HZ 960000000U
+#define PRESET_CPU_HZ 480000000U
+
+// Frequency limits of each voltage scale (datasheet, revision V silicon). The APB buses run at
+// up to half the HCLK limit.
+static const uint32_t vos_max_cpu_hz[4] = {480000000U, 400000000U, 300000000U, 200000000U};
+static const uint32_t vos_max_hclk_hz[4] = {240000000U, 200000000U, 150000000U, 100000000U};
+
+// Flash wait states for an AXI (HCLK) frequency at each voltage scale (RM0399 table 17).
+typedef struct {
+  uint32_t max_hz;
+  uint8_t latency;
+  uint8_t wrhighfreq;
+} flash_ws_t;
+
+static const flash_ws_t flash_ws_vos01[] = {
+  {70000000U, 0U, 0U},  {140000000U, 1U, 1U}, {185000000U, 2U, 1U},
+  {210000000U, 2U, 2U}, {225000000U, 3U, 2U}, {240000000U, 4U, 2U},
+};
+static const flash_ws_t flash_ws_vos2[] = {
+  {55000000U, 0U, 0U}, {110000000U, 1U, 1U}, {165000000U, 2U, 1U}, {225000000U, 3U, 2U},
+};
+static const flash_ws_t flash_ws_vos3[] = {
+  {45000000U, 0U, 0U},  {90000000U, 1U, 1U},  {135000000U, 2U, 1U},
+  {180000000U, 3U, 2U}, {225000000U, 4U, 2U},
+};
+
+// HSE frequency given to clock_init(). The RCC has no record of it.
+static uint32_t clock_hse_hz;
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+
+// Polls a field until it reads a value. Returns false on timeout.
+static bool clock_wait(ro_reg32_t reg, field32_t field, uint32_t value) {
+  for (uint32_t i = 0; i < CLOCK_TIMEOUT; i++) {
+    if (((*reg & field.msk) >> field.pos) == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Encodes a D1CPRE/HPRE division factor, or returns -1 if it is not available.
+static int32_t clock_ahb_div_encode(uint32_t div) {
+  if (div == 1U) {
+    return 0;
+  }
+  if (div == 32U || div > 512U || (div & (div - 1U)) != 0U) {
+    return -1;
+  }
+  uint32_t log2 = (uint32_t)__builtin_ctz(div);
+  return (int32_t)(((div > 32U) ? log2 - 1U : log2) + 7U);
+}
+
+static uint32_t clock_ahb_div_decode(uint32_t bits) {
+  if (bits < 8U) {
+    return 1U;
+  }
+  uint32_t log2 = bits - 7U;
+  return 1U << ((log2 >= 5U) ? log2 + 1U : log2);
+}
+
+// Encodes a D1PPRE/D2PPREx/D3PPRE division factor, or returns -1 if it is not available.
+static int32_t clock_apb_div_encode(uint32_t div) {
+  if (div == 1U) {
+    return 0;
+  }
+  if (div > 16U || (div & (div - 1U)) != 0U) {
+    return -1;
+  }
+  return (int32_t)((uint32_t)__builtin_ctz(div) + 3U);
+}
+
+static uint32_t clock_apb_div_decode(uint32_t bits) {
+  return (bits < 4U) ? 1U : 1U << (bits - 3U);
+}
+
+// PLLx dividers register. The three registers share one layout, so the PLL1 fields are used for
+// all of them, and likewise for the fractional registers.
+static rw_reg32_t clock_pll_divr(uint32_t pll) {
+  switch (pll) {
+    case 1:
+      return RCC_PLL1DIVR;
+    case 2:
+      return RCC_PLL2DIVR;
+    default:
+      return RCC_PLL3DIVR;
+  }
+}
+
+static rw_reg32_t clock_pll_fracr(uint32_t pll) {
+  switch (pll) {
+    case 1:
+      return RCC_PLL1FRACR;
+    case 2:
+      return RCC_PLL2FRACR;
+    default:
+      return RCC_PLL3FRACR;
+  }
+}
+
+static uint32_t clock_source_hz(clock_source_t source) {
+  switch (source) {
+    case CLOCK_SOURCE_HSI:
+      return CLOCK_HSI_HZ >> READ_FIELD(RCC_CR, RCC_CR_HSIDIV);
+    case CLOCK_SOURCE_CSI:
+      return CLOCK_CSI_HZ;
+    case CLOCK_SOURCE_HSE:
+      return clock_hse_hz;
+    default:
+      return 0U;
+  }
+}
+
+// Output of a running PLL (1-3), output 0-2 for P/Q/R, or 0 if it is off.
+static uint32_t clock_pll_hz(uint32_t pll, uint32_t output) {
+  if (!IS_FIELD_SET(RCC_CR, RCC_CR_PLLxRDY[pll])) {
+    return 0U;
+  }
+  uint32_t m = READ_FIELD(RCC_PLLCKSELR, RCC_PLLCKSELR_DIVMx[pll]);
+  field32_t enable = (output == 0U) ? RCC_PLLCFGR_DIVPxEN[pll]
+                   : (output == 1U) ? RCC_PLLCFGR_DIVQxEN[pll] : RCC_PLLCFGR_DIVRxEN[pll];
+  if (m == 0U || !IS_FIELD_SET(RCC_PLLCFGR, enable)) {
+    return 0U;
+  }
+  rw_reg32_t divr = clock_pll_divr(pll);
+  uint64_t n_frac = (uint64_t)(READ_FIELD(divr, RCC_PLL1DIVR_DIVN1) + 1U) * 8192U;
+  if (IS_FIELD_SET(RCC_PLLCFGR, RCC_PLLCFGR_PLLxFRACEN[pll])) {
+    n_frac += READ_FIELD(clock_pll_fracr(pll), RCC_PLL1FRACR_FRACN1);
+  }
+  field32_t div_field = (output == 0U) ? RCC_PLL1DIVR_DIVP1
+                      : (output == 1U) ? RCC_PLL1DIVR_DIVQ1 : RCC_PLL1DIVR_DIVR1;
+  uint32_t div = READ_FIELD(divr, div_field) + 1U;
+  uint32_t src = clock_source_hz((clock_source_t)READ_FIELD(RCC_PLLCKSELR, RCC_PLLCKSELR_PLLSRC));
+  return (uint32_t)((uint64_t)src * n_frac / ((uint64_t)m * 8192U * div));
+}
+
+// Timer kernel clock of an APB bus, given its prescaler and TIMPRE (RM0399 section 8.5.9).
+static uint32_t clock_timer_hz(uint32_t apb_div) {
+  uint32_t hclk = clock_get_hz(CLOCK_HCLK);
+  uint32_t mult = IS_FIELD_SET(RCC_CFGR, RCC_CFGR_TIMPRE) ? 4U : 2U;
+  return (apb_div <= mult) ? hclk : hclk / apb_div * mult;
+}
+
+static clock_vos_t clock_current_vos(void) {
+  if (IS_FIELD_SET(RCC_APB4ENR, RCC_APB4ENR_SYSCFGEN) &&
+      IS_FIELD_SET(SYSCFG_PWRCR, SYSCFG_PWRCR_ODEN)) {
+    return CLOCK_VOS0;
+  }
+  uint32_t bits = READ_FIELD(PWR_D3CR, PWR_D3CR_VOS);
+  return (bits == 0U) ? CLOCK_VOS3 : (clock_vos_t)(4U - bits);
+}
+
+// Switches the voltage scale. VOS0 is VOS1 with the overdrive enabled on top.
+static bool clock_set_vos(clock_vos_t vos) {
+  SET_FIELD(RCC_APB4ENR, RCC_APB4ENR_SYSCFGEN);
+  if (IS_FIELD_SET(SYSCFG_PWRCR, SYSCFG_PWRCR_ODEN)) {
+    CLR_FIELD(SYSCFG_PWRCR, SYSCFG_PWRCR_ODEN);
+    if (!clock_wait(PWR_D3CR, PWR_D3CR_VOSRDY, 1U)) {
+      return false;
+    }
+  }
+  uint32_t bits = (vos == CLOCK_VOS0) ? 3U : 4U - (uint32_t)vos;
+  WRITE_FIELD(PWR_D3CR, PWR_D3CR_VOS, bits);
+  if (!clock_wait(PWR_D3CR, PWR_D3CR_VOSRDY, 1U)) {
+    return false;
+  }
+  if (vos == CLOCK_VOS0) {
+    SET_FIELD(SYSCFG_PWRCR, SYSCFG_PWRCR_ODEN);
+    return clock_wait(PWR_D3CR, PWR_D3CR_VOSRDY, 1U);
+  }
+  return true;
+}
+
+// Flash wait states for an HCLK frequency, or NULL if it is above what the scale allows.
+static const flash_ws_t *clock_flash_ws(clock_vos_t vos, uint32_t hclk_hz) {
+  const flash_ws_t *table = flash_ws_vos01;
+  size_t count = sizeof(flash_ws_vos01) / sizeof(flash_ws_vos01[0]);
+  if (vos == CLOCK_VOS2) {
+    table = flash_ws_vos2;
+    count = sizeof(flash_ws_vos2) / sizeof(flash_ws_vos2[0]);
+  } else if (vos == CLOCK_VOS3) {
+    table = flash_ws_vos3;
+    count = sizeof(flash_ws_vos3) / sizeof(flash_ws_vos3[0]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (hclk_hz <= table[i].max_hz) {
+      return &table[i];
+    }
+  }
+  return NULL;
+}
+
+static bool clock_set_flash_ws(uint32_t latency, uint32_t wrhighfreq) {
+  WRITE_FIELD(FLASH_ACR, FLASH_ACR_LATENCY, latency);
+  WRITE_FIELD(FLASH_ACR, FLASH_ACR_WRHIGHFREQ, wrhighfreq);
+  return clock_wait(FLASH_ACR, FLASH_ACR_LATENCY, latency);
+}
+
+// Checks one PLL's settings against the source. Returns the VCO frequency, or 0 if invalid.
+static uint32_t clock_check_pll(const clock_pll_t *pll, uint32_t pll_num, uint32_t src_hz) {
+  if (pll->m > PLL_M_MAX || pll->n < PLL_N_MIN || pll->n > PLL_N_MAX ||
+      pll->p > PLL_DIV_MAX || pll->q > PLL_DIV_MAX || pll->r > PLL_DIV_MAX) {
+    return 0U;
+  }
+  if (pll_num == 1U && pll->p > 1U && (pll->p & 1U) != 0U) {
+    return 0U; // PLL1 P only divides by 1 or even factors
+  }
+  uint32_t ref_hz = src_hz / pll->m;
+  if (ref_hz < PLL_REF_MIN_HZ || ref_hz > PLL_REF_MAX_HZ) {
+    return 0U;
+  }
+  uint64_t vco_hz = (uint64_t)ref_hz * pll->n;
+  bool wide = ref_hz >= PLL_WIDE_REF_MIN_HZ;
+  if (vco_hz < (wide ? PLL_WIDE_VCO_MIN_HZ : PLL_MEDIUM_VCO_MIN_HZ) ||
+      vco_hz > (wide ? PLL_WIDE_VCO_MAX_HZ : PLL_MEDIUM_VCO_MAX_HZ)) {
+    return 0U;
+  }
+  return (uint32_t)vco_hz;
+}
+
+// Programs and starts one PLL (1-3). The PLL must be off.
+static bool clock_start_pll(const clock_pll_t *pll, uint32_t pll_num, uint32_t src_hz) {
+  uint32_t ref_hz = src_hz / pll->m;
+  uint32_t range = (ref_hz >= 8000000U) ? 3U : (ref_hz >= 4000000U) ? 2U
+                 : (ref_hz >= 2000000U) ? 1U : 0U;
+  WRITE_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_PLLxRGE[pll_num], range);
+  uint32_t medium_vco = (ref_hz < PLL_WIDE_REF_MIN_HZ) ? 1U : 0U;
+  WRITE_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_PLLxVCOSEL[pll_num], medium_vco);
+  CLR_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_PLLxFRACEN[pll_num]);
+  WRITE_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_DIVPxEN[pll_num], (pll->p != 0U) ? 1U : 0U);
+  WRITE_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_DIVQxEN[pll_num], (pll->q != 0U) ? 1U : 0U);
+  WRITE_FIELD(RCC_PLLCFGR, RCC_PLLCFGR_DIVRxEN[pll_num], (pll->r != 0U) ? 1U : 0U);
+
+  rw_reg32_t divr = clock_pll_divr(pll_num);
+  *divr = TO_FIELD(pll->n - 1U, RCC_PLL1DIVR_DIVN1) |
+          TO_FIELD((pll->p != 0U) ? pll->p - 1U : 0U, RCC_PLL1DIVR_DIVP1) |
+          TO_FIELD((pll->q != 0U) ? pll->q - 1U : 0U, RCC_PLL1DIVR_DIVQ1) |
+          TO_FIELD((pll->r != 0U) ? pll->r - 1U : 0U, RCC_PLL1DIVR_DIVR1);
+  *clock_pll_fracr(pll_num) = 0U;
+
+  SET_FIELD(RCC_CR, RCC_CR_PLLxON[pll_num]);
+  return clock_wait(RCC_CR, RCC_CR_PLLxRDY[pll_num], 1U);
+}
+
+static bool clock_start_source(const clock_config_t *config) {
+  if (config->source == CLOCK_SOURCE_CSI) {
+    SET_FIELD(RCC_CR, RCC_CR_CSION);
+    return clock_wait(RCC_CR, RCC_CR_CSIRDY, 1U);
+  }
+  if (config->source == CLOCK_SOURCE_HSE) {
+    // HSEBYP can only change while the HSE is off.
+    if (READ_FIELD(RCC_CR, RCC_CR_HSEBYP) != (config->hse_bypass ? 1U : 0U)) {
+      CLR_FIELD(RCC_CR, RCC_CR_HSEON);
+      if (!clock_wait(RCC_CR, RCC_CR_HSERDY, 0U)) {
+        return false;
+      }
+      WRITE_FIELD(RCC_CR, RCC_CR_HSEBYP, config->hse_bypass ? 1U : 0U);
+    }
+    SET_FIELD(RCC_CR, RCC_CR_HSEON);
+    return clock_wait(RCC_CR, RCC_CR_HSERDY, 1U);
+  }
+  return true; // The HSI is always on while the core runs from it
+}
+
+static bool clock_switch(uint32_t sw) {
+  WRITE_FIELD(RCC_CFGR, RCC_CFGR_SW, sw);
+  return clock_wait(RCC_CFGR, RCC_CFGR_SWS, sw);
+}
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+
+bool clock_config_480mhz(uint32_t hse_hz, clock_config_t *config) {
+  if (config == NULL) {
+    return false;
+  }
+  *config = (clock_config_t){
+    .source = (hse_hz == 0U) ? CLOCK_SOURCE_HSI : CLOCK_SOURCE_HSE,
+    .hse_hz = hse_hz,
+    .supply = CLOCK_SUPPLY_LDO,
+    .vos = CLOCK_VOS0,
+    .cpu_div = 1U,
+    .ahb_div = 2U,
+    .apb_div = {2U, 2U, 2U, 2U},
+  };
+  uint32_t src_hz = (hse_hz == 0U) ? CLOCK_HSI_HZ : hse_hz;
+
+  // Highest reference that divides the VCO exactly, for the least jitter.
+  for (uint32_t m = 1U; m <= PLL_M_MAX; m++) {
+    uint32_t ref_hz = src_hz / m;
+    if (src_hz % m != 0U || ref_hz > PLL_REF_MAX_HZ || PRESET_VCO_HZ % ref_hz != 0U) {
+      continue;
+    }
+    if (ref_hz < PLL_WIDE_REF_MIN_HZ) {
+      return false;
+    }
+    config->pll[0] = (clock_pll_t){
+      .m = (uint8_t)m,
+      .n = (uint16_t)(PRESET_VCO_HZ / ref_hz),
+      .p = (uint8_t)(PRESET_VCO_HZ / PRESET_CPU_HZ),
+      .q = 8U, // 120 MHz, the default SPI1-3 kernel clock
+      .r = 8U,
+    };
+    return config->pll[0].n <= PLL_N_MAX;
+  }
+  return false;
+}
+
+bool clock_init(const clock_config_t *config) {
+  if (config == NULL || config->vos > CLOCK_VOS3 || config->source > CLOCK_SOURCE_HSE) {
+    return false;
+  }
+  if (config->source == CLOCK_SOURCE_HSE &&
+      (config->hse_hz < HSE_MIN_HZ || config->hse_hz > HSE_MAX_HZ)) {
+    return false;
+  }
+  int32_t cpu_bits = clock_ahb_div_encode(config->cpu_div);
+  int32_t ahb_bits = clock_ahb_div_encode(config->ahb_div);
+  int32_t apb_bits[4];
+  for (uint32_t i = 0; i < 4U; i++) {
+    apb_bits[i] = clock_apb_div_encode(config->apb_div[i]);
+    if (apb_bits[i] < 0) {
+      return false;
+    }
+  }
+  if (cpu_bits < 0 || ahb_bits < 0) {
+    return false;
+  }
+
+  // Check the PLLs and the resulting bus clocks against the voltage scale.
+  uint32_t src_hz = (config->source == CLOCK_SOURCE_HSE) ? config->hse_hz
+                                                          : clock_source_hz(config->source);
+  uint32_t sys_hz = src_hz;
+  for (uint32_t i = 0; i < 3U; i++) {
+    const clock_pll_t *pll = &config->pll[i];
+    if (pll->m == 0U) {
+      continue;
+    }
+    uint32_t vco_hz = clock_check_pll(pll, i + 1U, src_hz);
+    if (vco_hz == 0U) {
+      return false;
+    }
+    if (i == 0U) {
+      if (pll->p == 0U) {
+        return false;
+      }
+      sys_hz = vco_hz / pll->p;
+    }
+  }
+  uint32_t cpu_hz = sys_hz / config->cpu_div;
+  uint32_t hclk_hz = cpu_hz / config->ahb_div;
+  if (cpu_hz > vos_max_cpu_hz[config->vos] || hclk_hz > vos_max_hclk_hz[config->vos]) {
+    return false;
+  }
+  for (uint32_t i = 0; i < 4U; i++) {
+    if (hclk_hz / config->apb_div[i] > vos_max_hclk_hz[config->vos] / 2U) {
+      return false;
+    }
+  }
+  const flash_ws_t *new_ws = clock_flash_ws(config->vos, hclk_hz);
+  if (new_ws == NULL) {
+    return false;
+  }
+
+  // Supply, then a higher voltage scale, before anything speeds up.
+  if (config->supply != CLOCK_SUPPLY_KEEP) {
+    bool ldo = config->supply == CLOCK_SUPPLY_LDO;
+    uint32_t cr3 = *PWR_CR3 & ~(PWR_CR3_BYPASS.msk | PWR_CR3_LDOEN.msk | PWR_CR3_SDEN.msk);
+    *PWR_CR3 = cr3 | (ldo ? PWR_CR3_LDOEN.msk : PWR_CR3_SDEN.msk);
+    if (!clock_wait(PWR_CSR1, PWR_CSR1_ACTVOSRDY, 1U)) {
+      return false;
+    }
+  }
+  clock_vos_t old_vos = clock_current_vos();
+  if (config->vos < old_vos && !clock_set_vos(config->vos)) {
+    return false;
+  }
+
+  // Wait states for whichever of the old and new clocks is faster.
+  uint32_t old_latency = READ_FIELD(FLASH_ACR, FLASH_ACR_LATENCY);
+  uint32_t old_wrhighfreq = READ_FIELD(FLASH_ACR, FLASH_ACR_WRHIGHFREQ);
+  if (!clock_set_flash_ws((new_ws->latency > old_latency) ? new_ws->latency : old_latency,
+                          (new_ws->wrhighfreq > old_wrhighfreq) ? new_ws->wrhighfreq
+                                                                : old_wrhighfreq)) {
+    return false;
+  }
+
+  // Run from the HSI while the source and PLLs are changed.
+  SET_FIELD(RCC_CR, RCC_CR_HSION);
+  if (!clock_wait(RCC_CR, RCC_CR_HSIRDY, 1U) || !clock_switch(CLOCK_SOURCE_HSI)) {
+    return false;
+  }
+  for (uint32_t i = 1; i <= 3U; i++) {
+    CLR_FIELD(RCC_CR, RCC_CR_PLLxON[i]);
+    if (!clock_wait(RCC_CR, RCC_CR_PLLxRDY[i], 0U)) {
+      return false;
+    }
+  }
+  clock_hse_hz = config->hse_hz;
+  if (!clock_start_source(config)) {
+    return false;
+  }
+  WRITE_FIELD(RCC_PLLCKSELR, RCC_PLLCKSELR_PLLSRC, config->source);
+  for (uint32_t i = 0; i < 3U; i++) {
+    WRITE_FIELD(RCC_PLLCKSELR, RCC_PLLCKSELR_DIVMx[i + 1U], config->pll[i].m);
+    if (config->pll[i].m != 0U && !clock_start_pll(&config->pll[i], i + 1U, src_hz)) {
+      return false;
+    }
+  }
+
+  // The prescalers only ever divide the HSI further until the switch, so they go first.
+  WRITE_FIELD(RCC_D1CFGR, RCC_D1CFGR_D1CPRE, (uint32_t)cpu_bits);
+  WRITE_FIELD(RCC_D1CFGR, RCC_D1CFGR_HPRE, (uint32_t)ahb_bits);
+  WRITE_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[1], (uint32_t)apb_bits[0]);
+  WRITE_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[2], (uint32_t)apb_bits[1]);
+  WRITE_FIELD(RCC_D1CFGR, RCC_D1CFGR_D1PPRE, (uint32_t)apb_bits[2]);
+  WRITE_FIELD(RCC_D3CFGR, RCC_D3CFGR_D3PPRE, (uint32_t)apb_bits[3]);
+  if (!clock_switch((config->pll[0].m != 0U) ? CLOCK_SW_PLL1 : (uint32_t)config->source)) {
+    return false;
+  }
+
+  // Then the wait states and voltage scale come down to what the new clocks need.
+  if (!clock_set_flash_ws(new_ws->latency, new_ws->wrhighfreq)) {
+    return false;
+  }
+  if (config->vos > old_vos && !clock_set_vos(config->vos)) {
+    return false;
+  }
+  return true;
+}
+
+uint32_t clock_get_hz(clock_domain_t domain) {
+  switch (domain) {
+    case CLOCK_SYS:
+      switch (READ_FIELD(RCC_CFGR, RCC_CFGR_SWS)) {
+        case CLOCK_SOURCE_HSI:
+          return clock_get_hz(CLOCK_HSI);
+        case CLOCK_SOURCE_CSI:
+          return CLOCK_CSI_HZ;
+        case CLOCK_SOURCE_HSE:
+          return clock_hse_hz;
+        default:
+          return clock_pll_hz(1U, 0U);
+      }
+    case CLOCK_CPU:
+      return clock_get_hz(CLOCK_SYS) / clock_ahb_div_decode(READ_FIELD(RCC_D1CFGR,
+                                                                       RCC_D1CFGR_D1CPRE));
+    case CLOCK_HCLK:
+      return clock_get_hz(CLOCK_CPU) / clock_ahb_div_decode(READ_FIELD(RCC_D1CFGR,
+                                                                       RCC_D1CFGR_HPRE));
+    case CLOCK_PCLK1:
+      return clock_get_hz(CLOCK_HCLK) /
+             clock_apb_div_decode(READ_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[1]));
+    case CLOCK_PCLK2:
+      return clock_get_hz(CLOCK_HCLK) /
+             clock_apb_div_decode(READ_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[2]));
+    case CLOCK_PCLK3:
+      return clock_get_hz(CLOCK_HCLK) /
+             clock_apb_div_decode(READ_FIELD(RCC_D1CFGR, RCC_D1CFGR_D1PPRE));
+    case CLOCK_PCLK4:
+      return clock_get_hz(CLOCK_HCLK) /
+             clock_apb_div_decode(READ_FIELD(RCC_D3CFGR, RCC_D3CFGR_D3PPRE));
+    case CLOCK_TIM_APB1:
+      return clock_timer_hz(clock_apb_div_decode(READ_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[1])));
+    case CLOCK_TIM_APB2:
+      return clock_timer_hz(clock_apb_div_decode(READ_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[2])));
+    case CLOCK_HSI:
+      return IS_FIELD_SET(RCC_CR, RCC_CR_HSIRDY)
+                 ? CLOCK_HSI_HZ >> READ_FIELD(RCC_CR, RCC_CR_HSIDIV) : 0U;
+    case CLOCK_CSI:
+      return IS_FIELD_SET(RCC_CR, RCC_CR_CSIRDY) ? CLOCK_CSI_HZ : 0U;
+    case CLOCK_HSE:
+      return IS_FIELD_SET(RCC_CR, RCC_CR_HSERDY) ? clock_hse_hz : 0U;
+    case CLOCK_LSE:
+      return IS_FIELD_SET(RCC_BDCR, RCC_BDCR_LSERDY) ? CLOCK_LSE_HZ : 0U;
+    case CLOCK_PER:
+      switch (READ_FIELD(RCC_D1CCIPR, RCC_D1CCIPR_CKPERSRC)) {
+        case 0:
+          return clock_get_hz(CLOCK_HSI);
+        case 1:
+          return clock_get_hz(CLOCK_CSI);
+        case 2:
+          return clock_get_hz(CLOCK_HSE);
+        default:
+          return 0U;
+      }
+    case CLOCK_PLL1_P:
+    case CLOCK_PLL1_Q:
+    case CLOCK_PLL1_R:
+    case CLOCK_PLL2_P:
+    case CLOCK_PLL2_Q:
+    case CLOCK_PLL2_R:
+    case CLOCK_PLL3_P:
+    case CLOCK_PLL3_Q:
+    case CLOCK_PLL3_R: {
+      uint32_t index = (uint32_t)domain - (uint32_t)CLOCK_PLL1_P;
+      return clock_pll_hz(index / 3U + 1U, index % 3U);
+    }
+    default:
+      return 0U;
+  }
+}
@@ -0,0 +1,154 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/clock.h
+ * @authors Charles Faisandier
+ * @brief RCC clock tree configuration and clock frequency queries.
+ *
+ * The core starts on the 64 MHz HSI at voltage scale 3. clock_init() brings up the oscillator,
+ * PLLs, voltage scale, flash wait states and bus prescalers for a configuration, and
+ * clock_get_hz() reports what any part of the tree is running at by reading the RCC back, so
+ * drivers can derive their dividers from the live clock rather than from a caller's constant.
+ *
+ * Clock tree (RM0399 section 8):
+ *   source (HSI/CSI/HSE) -> /M -> PLLx VCO (*N) -> /P, /Q, /R
+ *   sys_ck (PLL1 P or the source) -> /cpu_div = CM7 -> /ahb_div = HCLK (AXI/AHB, CM4)
+ *   HCLK -> /apb_div[0..3] = PCLK1 (APB1, D2), PCLK2 (APB2, D2), PCLK3 (APB3, D1), PCLK4 (APB4, D3)
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+
+/** @brief Internal oscillator frequencies, in Hz. The HSI is before its HSIDIV divider. */
+#define CLOCK_HSI_HZ 64000000U
+#define CLOCK_CSI_HZ 4000000U
+#define CLOCK_LSE_HZ 32768U
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+
+/** @brief PLL reference source, in RCC_PLLCKSELR encoding. Also clocks sys_ck if PLL1 is off. */
+typedef enum {
+  CLOCK_SOURCE_HSI,
+  CLOCK_SOURCE_CSI,
+  CLOCK_SOURCE_HSE,
+} clock_source_t;
+
+/**
+ * @brief Core supply configuration (PWR_CR3). It can be written once per power cycle, and has to
+ * match how the board is wired, so CLOCK_SUPPLY_KEEP leaves it alone. VOS0 needs the LDO.
+ */
+typedef enum {
+  CLOCK_SUPPLY_KEEP,
+  CLOCK_SUPPLY_LDO,
+  CLOCK_SUPPLY_SMPS, // SMPS supplies the core directly, LDO off
+} clock_supply_t;
+
+/** @brief Core voltage scale. Lower scales allow higher clocks (VOS0: 480 MHz, VOS3: 200 MHz). */
+typedef enum {
+  CLOCK_VOS0,
+  CLOCK_VOS1,
+  CLOCK_VOS2,
+  CLOCK_VOS3,
+} clock_vos_t;
+
+/** @brief Settings for one PLL. VCO = source / m * n, outputs = VCO / p, q, r. */
+typedef struct {
+  uint8_t m;  // Reference divider, 1-63, giving 1-16 MHz. 0 leaves the PLL off.
+  uint16_t n; // VCO multiplier, 4-512
+  uint8_t p;  // Output dividers, 1-128 (PLL1 P: 1 or even). 0 leaves that output off.
+  uint8_t q;
+  uint8_t r;
+} clock_pll_t;
+
+typedef struct {
+  clock_source_t source;
+  uint32_t hse_hz;       // Crystal or external clock frequency, if source is CLOCK_SOURCE_HSE
+  bool hse_bypass;       // HSE is an external clock rather than a crystal
+  clock_supply_t supply;
+  clock_vos_t vos;
+  clock_pll_t pll[3];    // PLL1-3. sys_ck is PLL1 P while PLL1 is on.
+  uint16_t cpu_div;      // sys_ck -> CM7 (D1CPRE): 1, 2, 4, 8, 16, 64, 128, 256 or 512
+  uint16_t ahb_div;      // CM7 -> HCLK (HPRE), same values
+  uint8_t apb_div[4];    // HCLK -> PCLK1-4: 1, 2, 4, 8 or 16
+} clock_config_t;
+
+/** @brief Points of the clock tree that can be queried with clock_get_hz(). */
+typedef enum {
+  CLOCK_SYS,      // sys_ck
+  CLOCK_CPU,      // CM7 core and its SysTick
+  CLOCK_HCLK,     // AXI/AHB buses, CM4 core
+  CLOCK_PCLK1,    // APB1 (D2): TIM2-7, TIM12-14, USART2/3, UART4/5/7/8, SPI2/3
+  CLOCK_PCLK2,    // APB2 (D2): TIM1/8/15-17, USART1/6, SPI1/4/5
+  CLOCK_PCLK3,    // APB3 (D1)
+  CLOCK_PCLK4,    // APB4 (D3): LPUART1, SPI6
+  CLOCK_TIM_APB1, // Timer kernel clock of the APB1 timers
+  CLOCK_TIM_APB2, // Timer kernel clock of the APB2 timers
+  CLOCK_HSI,      // hsi_ck, after HSIDIV
+  CLOCK_CSI,
+  CLOCK_HSE,
+  CLOCK_LSE,
+  CLOCK_PER,      // per_ck, the common peripheral kernel clock
+  CLOCK_PLL1_P,
+  CLOCK_PLL1_Q,
+  CLOCK_PLL1_R,
+  CLOCK_PLL2_P,
+  CLOCK_PLL2_Q,
+  CLOCK_PLL2_R,
+  CLOCK_PLL3_P,
+  CLOCK_PLL3_Q,
+  CLOCK_PLL3_R,
+  CLOCK_DOMAIN_COUNT,
+} clock_domain_t;
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+
+/**
+ * @brief Fills in a configuration that runs the CM7 at 480 MHz (VOS0, LDO supply), with HCLK at
+ *        240 MHz and every APB bus at 120 MHz. PLL2 and PLL3 are left off.
+ * @param hse_hz (uint32_t) HSE frequency to use as the source, or 0 to run from the HSI.
+ * @param config (clock_config_t*) Configuration to fill in.
+ * @returns (bool) True on success, false if no PLL1 setting reaches 480 MHz from hse_hz.
+ */
+bool clock_config_480mhz(uint32_t hse_hz, clock_config_t *config);
+
+/**
+ * @brief Switches the clock tree to a configuration.
+ * @param config (const clock_config_t*) Configuration to apply.
+ * @returns (bool) True on success, false if the configuration is invalid or exceeds the limits
+ *          of its voltage scale, or an oscillator, PLL or regulator did not become ready.
+ * @note - The voltage scale and flash wait states are raised before the clocks speed up, and
+ *         lowered after they slow down. The core runs from the HSI while the PLLs are changed.
+ * @note - Peripherals set up before this call keep the dividers they computed from the old
+ *         clocks, so it should run first thing in the application.
+ */
+bool clock_init(const clock_config_t *config);
+
+/**
+ * @brief Gets the current frequency of a point of the clock tree.
+ * @param domain (clock_domain_t) Clock to query.
+ * @returns (uint32_t) Frequency in Hz, or 0 if the clock is off or unknown (the HSE is only
+ *          known once clock_init() has been given its frequency).
+ */
+uint32_t clock_get_hz(clock_domain_t domain);
@@ -0,0 +1,129 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/cm4.c
+ * @authors Charles Faisandier
+ * @brief Cortex-M4 boot and workload assignment.
+ */
+
+#include "cm4.h"
+#include "interrupt.h"
+#include "mmio.h"
+#include "sections.h"
+#include <stddef.h>
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+
+// SCB_CPUID part number of the Cortex-M4.
+#define CM4_PARTNO 0xC24U
+
+// HSEM core IDs.
+#define HSEM_COREID_CM7 3U
+
+typedef enum {
+  CM4_STATE_HELD = 0, // Zero, so the cleared boot block starts here
+  CM4_STATE_RELEASED,
+  CM4_STATE_RUNNING,
+} cm4_state_t;
+
+// Handed from the CM7 to the CM4. Written only while the CM4 is held.
+typedef struct {
+  volatile uint32_t state;
+  cm4_task_t entry;
+  void *context;
+  uint32_t irq_count;
+  int32_t irqs[CM4_MAX_IRQS];
+  uint8_t priorities[CM4_MAX_IRQS];
+} cm4_boot_block_t;
+
+static TI_SHARED cm4_boot_block_t cm4_boot_block;
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+
+bool cm4_is_current_core(void) {
+  return READ_FIELD(SCB_CPUID, SCB_CPUID_PARTNO) == CM4_PARTNO;
+}
+
+bool cm4_assign_irq(int32_t irq, uint32_t priority) {
+  if (cm4_is_current_core() || cm4_boot_block.state != CM4_STATE_HELD || irq < 0 ||
+      irq >= IRQ_COUNT || cm4_boot_block.irq_count >= CM4_MAX_IRQS) {
+    return false;
+  }
+  irq_disable(irq);
+  cm4_boot_block.irqs[cm4_boot_block.irq_count] = irq;
+  cm4_boot_block.priorities[cm4_boot_block.irq_count] = (uint8_t)priority;
+  cm4_boot_block.irq_count++;
+  return true;
+}
+
+bool cm4_boot(cm4_task_t entry, void *context) {
+  if (cm4_is_current_core() || cm4_boot_block.state != CM4_STATE_HELD) {
+    return false;
+  }
+  cm4_boot_block.entry = entry;
+  cm4_boot_block.context = context;
+  cm4_boot_block.state = CM4_STATE_RELEASED;
+  // SRAM4 is non-cacheable, so the block is in memory once the writes complete.
+  __asm__ volatile ("dsb" ::: "memory");
+
+  // Taking and freeing the boot semaphore wakes a CM4 that started with the CM7. A CM4 gated
+  // by the BCM4 option bit is started instead, and finds BOOT_C2 set.
+  SET_FIELD(RCC_AHB4ENR, RCC_AHB4ENR_HSEMEN);
+  uint32_t lock = *HSEM_RLRx[CM4_BOOT_SEM];
+  if (READ_FIELD(&lock, HSEM_RLRx_COREID) == HSEM_COREID_CM7) {
+    *HSEM_Rx[CM4_BOOT_SEM] = TO_FIELD(HSEM_COREID_CM7, HSEM_Rx_COREID);
+  }
+  SET_FIELD(RCC_GCR, RCC_GCR_BOOT_C2);
+  return true;
+}
+
+bool cm4_running(void) {
+  return cm4_boot_block.state == CM4_STATE_RUNNING;
+}
+
+void cm4_wait_for_boot(void) {
+  if (IS_FIELD_SET(RCC_GCR, RCC_GCR_BOOT_C2)) {
+    return; // Started by cm4_boot(), so the boot block is ready
+  }
+  // Sleep until the boot semaphore is freed. SEVONPEND lets the (disabled) HSEM interrupt
+  // wake WFE without being taken.
+  field32_t sem = HSEM_IER_ISEMx[CM4_BOOT_SEM];
+  SET_FIELD(RCC_AHB4ENR, RCC_AHB4ENR_HSEMEN);
+  SET_FIELD(HSEM_C2IER, sem);
+  SET_FIELD(SCB_SCR, SCB_SCR_SEVEONPEND);
+  while (!IS_FIELD_SET(HSEM_C2ISR, sem) || cm4_boot_block.state != CM4_STATE_RELEASED) {
+    __asm__ volatile ("wfe");
+  }
+  CLR_FIELD(HSEM_C2IER, sem);
+  *HSEM_C2ICR = sem.msk;
+  CLR_FIELD(SCB_SCR, SCB_SCR_SEVEONPEND);
+  irq_clear_pending(HSEMx_IRQ_NUM[1]);
+}
+
+void cm4_start(void) {
+  for (uint32_t i = 0; i < cm4_boot_block.irq_count; i++) {
+    irq_set_priority(cm4_boot_block.irqs[i], cm4_boot_block.priorities[i]);
+    irq_enable(cm4_boot_block.irqs[i]);
+  }
+  cm4_boot_block.state = CM4_STATE_RUNNING;
+  if (cm4_boot_block.entry != NULL) {
+    cm4_boot_block.entry(cm4_boot_block.context);
+  }
+}
@@ -0,0 +1,103 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/cm4.h
+ * @authors Charles Faisandier
+ * @brief Cortex-M4 boot and workload assignment.
+ *
+ * Both cores run the same image. The CM4 boots from FLASH_BK2 (.cm4_vtable), and its reset
+ * handler holds it until the CM7 calls cm4_boot(). It does not rely on the BCM4 option bit:
+ * a CM4 that started with the CM7 waits for the boot semaphore to be released, and a gated
+ * CM4 is started by cm4_boot() through RCC_GCR.
+ *
+ * Once released, the CM4 loads its own sections (TI_CM4_DATA/TI_CM4_BSS), builds a vector table
+ * in SRAM4, enables the IRQs assigned to it and runs its entry task. All other data was set up
+ * by the CM7 before the release. Peripherals belong to the core that initializes them: clock
+ * enables land in that core's RCC registers and IRQs in its NVIC, so a CM4 task should set up
+ * the peripherals it uses itself.
+ *
+ * The CM4 has no data cache, but the CM7 does, so data the cores exchange belongs in SRAM4
+ * (TI_SHARED). The CM4 cannot reach the CM7 TCMs, so it cannot use anything placed with
+ * TI_FAST_CODE/TI_FAST_DATA/TI_FAST_BSS, which includes the DMA driver.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+
+/** @brief HSEM semaphore the CM7 releases to start the CM4. Not to be used for anything else. */
+#define CM4_BOOT_SEM 0U
+
+/** @brief Maximum number of IRQs that can be assigned with cm4_assign_irq(). */
+#define CM4_MAX_IRQS 16U
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+
+/** @brief Work run on the CM4. */
+typedef void (*cm4_task_t)(void *context);
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+
+/**
+ * @brief Checks which core the caller runs on.
+ * @returns (bool) True on the CM4, false on the CM7.
+ */
+bool cm4_is_current_core(void);
+
+/**
+ * @brief Hands an IRQ to the CM4: it is disabled on the CM7, and enabled on the CM4 with the
+ *        given priority once the CM4 boots. For peripherals set up by the CM7 but serviced by
+ *        the CM4. Their handlers must not be placed in the CM7 TCMs.
+ * @param irq (int32_t) The IRQ number.
+ * @param priority (uint32_t) NVIC priority on the CM4 (0-15).
+ * @returns (bool) True on success, false if called on the CM4 or after cm4_boot(), the IRQ
+ *          number is invalid, or CM4_MAX_IRQS are already assigned.
+ */
+bool cm4_assign_irq(int32_t irq, uint32_t priority);
+
+/**
+ * @brief Starts the CM4. Called once by the CM7, after everything the CM4 task uses is set up.
+ * @param entry (cm4_task_t) Task the CM4 runs once booted, or NULL to only service its IRQs.
+ *        When the task returns the CM4 sleeps between interrupts.
+ * @param context (void*) Passed to the task.
+ * @returns (bool) True if the CM4 was released, false if called on the CM4 or more than once.
+ */
+bool cm4_boot(cm4_task_t entry, void *context);
+
+/**
+ * @brief Checks whether the CM4 has booted and started its task.
+ * @returns (bool) True once the CM4 is running.
+ */
+bool cm4_running(void);
+
+/**
+ * @brief Holds the CM4 until cm4_boot() is called. Called from the CM4 reset handler.
+ */
+void cm4_wait_for_boot(void);
+
+/**
+ * @brief Enables the assigned IRQs and runs the entry task. Called from the CM4 reset handler
+ *        once its sections and vector table are set up.
+ */
+void cm4_start(void);
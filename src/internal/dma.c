@@ -1,16 +1,779 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2024 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/dma.c
+ * @authors Charles Faisandier
+ * @brief DMA driver implementation.
+ */
 #include "dma.h"
+#include "cache.h"
+#include "interrupt.h"
+#include "mmio.h"
+#include "sections.h"
 
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+// NVIC priority of the DMA stream and MDMA interrupts. Completions pre-empt the UART
+// (telemetry) interrupts so a slow formatting path does not delay the next transfer.
+#define DMA_IRQ_PRIORITY 2U
+
+// MDMA channel reserved for the memory copy engine.
+#define MDMA_MEM_CHANNEL 0
+
+// MDMA channel reserved for hardware-paced peripheral transfers.
+#define MDMA_PERIPH_CHANNEL 1
+
+// Largest block a single MDMA block transfer can move (BNDT is 17 bits, max 64 KiB).
+#define MDMA_MAX_BLOCK_SIZE 0x10000U
+
+// MDMA register encodings.
+#define MDMA_INC_FIXED  0x0U
+#define MDMA_INC_UP     0x2U
+#define MDMA_SIZE_BYTE  0x0U
+#define MDMA_SIZE_WORD  0x2U
+#define MDMA_TLEN_MAX   127U // 128 byte internal buffer transfers
+#define MDMA_TRGM_BUFFER 0x0U // Each (hardware) request moves one buffer of TLEN + 1 bytes
+#define MDMA_TRGM_BLOCK 0x1U // Each (software) request moves a full block
+#define MDMA_IFCR_ALL   0x1FU
+
+// Stream interrupt flags, relative to the stream's offset in the xISR/xIFCR registers.
+#define DMA_FLAG_FE  0x01U
+#define DMA_FLAG_DME 0x04U
+#define DMA_FLAG_TE  0x08U
+#define DMA_FLAG_HT  0x10U
+#define DMA_FLAG_TC  0x20U
+#define DMA_FLAG_ALL 0x3DU
+
+// Largest number of data items a stream can move per segment (NDT is 16 bits).
+#define DMA_MAX_ITEMS 0xFFFFU
+
+// DMAMUX1 channels 0-7 feed DMA1 streams 0-7, channels 8-15 feed DMA2 streams 0-7.
+#define DMAMUX1_CHANNELS_PER_DMA 8
+
+// A transfer waiting for (or running on) a DMA1/2 stream.
+typedef struct {
+    uintptr_t periph;
+    const dma_segment_t *segments;
+    size_t segment_count;
+    dma_segment_t single; // Backing segment for dma_start_transfer()
+    void *context;
+    bool mem_inc;
+} dma_stream_req_t;
+
+// Runtime state of a DMA1/2 stream. The queue is a ring buffer; the request at head is
+// in flight whenever count is non-zero.
+typedef struct {
+    bool configured;
+    dma_direction_t direction;
+    uint32_t item_size; // Bytes per peripheral data item
+    dma_callback_t callback;
+    dma_stream_req_t queue[DMA_STREAM_QUEUE_LEN];
+    volatile uint32_t head;
+    volatile uint32_t count;
+    size_t segment_index; // Next segment of the in-flight request
+} dma_stream_state_t;
+
+TI_FAST_BSS static dma_stream_state_t stream_state[DMA_INSTANCE_COUNT][DMA_STREAM_COUNT];
+
+// Stream configuration registers, indexed by stream and then instance.
+static rw_reg32_t const *const dma_sxcr[DMA_STREAM_COUNT] = {
+    DMAx_S0CR, DMAx_S1CR, DMAx_S2CR, DMAx_S3CR,
+    DMAx_S4CR, DMAx_S5CR, DMAx_S6CR, DMAx_S7CR,
+};
+
+// A queued memory operation. src is NULL for memset requests.
+typedef struct {
+    void *dest;
+    const void *src;
+    size_t size;
+    uint8_t fill;
+    dma_callback_t callback;
+    void *context;
+} mdma_mem_req_t;
+
+// Memory engine state. The queue is a ring buffer; the request at mem_head is in flight.
+static mdma_mem_req_t mem_queue[DMA_MEM_QUEUE_LEN];
+static volatile uint32_t mem_head = 0;
+static volatile uint32_t mem_count = 0;
+static size_t mem_offset = 0; // Bytes of the in-flight request already transferred
+static uint32_t mem_chunk = 0; // Size of the block currently being transferred
+static bool mem_ready = false;
+
+// Completion callback of the transfer on the peripheral channel, NULL when idle.
+static dma_callback_t periph_callback = NULL;
+static void *periph_context = NULL;
+static void *periph_rx_mem = NULL; // Buffer to invalidate on completion, NULL for TX
+static size_t periph_rx_size = 0;
+static volatile bool periph_busy = false;
+
+// Source word for memset transfers. Lives in .bss (AXI SRAM), so the MDMA reads it over
+// AXI where a fixed (non-incrementing) source address is permitted.
+static uint32_t mem_fill_word;
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+// Whether an address is in a TCM, which the MDMA must reach through its AHB slave port.
+static inline bool mdma_is_tcm(uintptr_t addr) {
+    return (addr < 0x00010000U) || (addr >= 0x20000000U && addr < 0x20020000U);
+}
+
+static void mem_cpu_run(const mdma_mem_req_t *req) {
+    uint8_t *dst = (uint8_t *)req->dest;
+    size_t n = req->size;
+    if (req->src != NULL) {
+        const uint8_t *src = (const uint8_t *)req->src;
+        if ((((uintptr_t)dst | (uintptr_t)src) & 3U) == 0U) {
+            for (; n >= 4U; n -= 4U, dst += 4, src += 4) {
+                *(uint32_t *)dst = *(const uint32_t *)src;
+            }
+        }
+        while (n--) {
+            *dst++ = *src++;
+        }
+    } else {
+        if (((uintptr_t)dst & 3U) == 0U) {
+            uint32_t word = req->fill * 0x01010101U;
+            for (; n >= 4U; n -= 4U, dst += 4) {
+                *(uint32_t *)dst = word;
+            }
+        }
+        while (n--) {
+            *dst++ = req->fill;
+        }
+    }
+}
+
+// Programs and software-triggers the next block of the request at the head of the queue.
+static void mdma_launch_block(void) {
+    const mdma_mem_req_t *req = &mem_queue[mem_head];
+    const int ch = MDMA_MEM_CHANNEL;
+
+    size_t remaining = req->size - mem_offset;
+    mem_chunk = (remaining > MDMA_MAX_BLOCK_SIZE) ? MDMA_MAX_BLOCK_SIZE : (uint32_t)remaining;
+
+    uintptr_t dst = (uintptr_t)req->dest + mem_offset;
+    uintptr_t src;
+    if (req->src != NULL) {
+        src = (uintptr_t)req->src + mem_offset;
+    } else {
+        mem_fill_word = req->fill * 0x01010101U;
+        cache_clean(&mem_fill_word, sizeof(mem_fill_word));
+        src = (uintptr_t)&mem_fill_word;
+    }
+
+    // Use word beats when every address and the block length allow it.
+    bool word = ((dst | src | mem_chunk) & 3U) == 0U;
+    uint32_t size = word ? MDMA_SIZE_WORD : MDMA_SIZE_BYTE;
+
+    uint32_t tcr = TO_FIELD(req->src != NULL ? MDMA_INC_UP : MDMA_INC_FIXED, MDMA_MDMA_CxTCR_SINC)
+                 | TO_FIELD(MDMA_INC_UP, MDMA_MDMA_CxTCR_DINC)
+                 | TO_FIELD(size, MDMA_MDMA_CxTCR_SSIZE)
+                 | TO_FIELD(size, MDMA_MDMA_CxTCR_DSIZE)
+                 | TO_FIELD(size, MDMA_MDMA_CxTCR_SINCOS)
+                 | TO_FIELD(size, MDMA_MDMA_CxTCR_DINCOS)
+                 | TO_FIELD(MDMA_TLEN_MAX, MDMA_MDMA_CxTCR_TLEN)
+                 | TO_FIELD(MDMA_TRGM_BLOCK, MDMA_MDMA_CxTCR_TRGM)
+                 | MDMA_MDMA_CxTCR_SWRM.msk;
+
+    uint32_t tbr = (mdma_is_tcm(src) ? MDMA_MDMA_CxTBR_SBUS.msk : 0U)
+                 | (mdma_is_tcm(dst) ? MDMA_MDMA_CxTBR_DBUS.msk : 0U);
+
+    CLR_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    *MDMA_MDMA_CxIFCR[ch] = MDMA_IFCR_ALL;
+    *MDMA_MDMA_CxTCR[ch] = tcr;
+    *MDMA_MDMA_CxBNDTR[ch] = TO_FIELD(mem_chunk, MDMA_MDMA_CxBNDTR_BNDT);
+    *MDMA_MDMA_CxSAR[ch] = (uint32_t)src;
+    *MDMA_MDMA_CxDAR[ch] = (uint32_t)dst;
+    *MDMA_MDMA_CxTBR[ch] = tbr;
+    *MDMA_MDMA_CxLAR[ch] = 0U;
+
+    SET_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    SET_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_SWRQ);
+}
+
+static void mdma_cache_prepare(const mdma_mem_req_t *req) {
+    if (req->src != NULL) {
+        cache_clean(req->src, req->size);
+    }
+    cache_clean_invalidate(req->dest, req->size);
+}
+
+// Adds a request to the engine queue, starting it immediately if the engine is idle.
+static bool mdma_submit(const mdma_mem_req_t *req) {
+    if (!mem_ready || req->dest == NULL || req->size == 0U) {
+        return false;
+    }
+
+    // The MDMA works on memory, not the data cache: write the source back, and write back and
+    // drop the destination's lines so none is evicted over the copy. Requests small enough to
+    // be run by the CPU skip this unless they end up queued.
+    bool prepared = (req->size >= DMA_MEM_CPU_THRESHOLD);
+    if (prepared) {
+        mdma_cache_prepare(req);
+    }
+
+    uint32_t primask = irq_save();
+
+    // Small requests on an idle engine are cheaper on the CPU. Performing them with
+    // interrupts masked keeps them ordered with respect to queued requests.
+    if (mem_count == 0U && req->size < DMA_MEM_CPU_THRESHOLD) {
+        mem_cpu_run(req);
+        irq_restore(primask);
+        if (req->callback != NULL) {
+            req->callback(true, req->context);
+        }
+        return true;
+    }
+
+    if (mem_count == DMA_MEM_QUEUE_LEN) {
+        irq_restore(primask);
+        return false;
+    }
+    if (!prepared) {
+        mdma_cache_prepare(req);
+    }
+
+    mem_queue[(mem_head + mem_count) % DMA_MEM_QUEUE_LEN] = *req;
+    mem_count++;
+    if (mem_count == 1U) {
+        mem_offset = 0U;
+        mdma_launch_block();
+    }
+
+    irq_restore(primask);
+    return true;
+}
+
+static inline bool dma_stream_valid(dma_instance_t instance, dma_stream_t stream) {
+    return instance >= DMA1 && instance < DMA_INSTANCE_COUNT &&
+           stream >= DMA_STREAM_0 && stream < DMA_STREAM_COUNT;
+}
+
+// Bit offset of a stream's flags in its xISR/xIFCR register. Streams 4-7 use the same
+// offsets in the high registers as streams 0-3 do in the low registers.
+static inline uint32_t dma_flag_shift(dma_stream_t stream) {
+    return DMAx_LISR_FEIFx[stream % 4].pos;
+}
+
+static inline uint32_t dma_read_flags(dma_instance_t instance, dma_stream_t stream) {
+    ro_reg32_t isr = (stream < DMA_STREAM_4) ? DMAx_LISR[instance] : DMAx_HISR[instance];
+    return (*isr >> dma_flag_shift(stream)) & DMA_FLAG_ALL;
+}
+
+static inline void dma_clear_flags(dma_instance_t instance, dma_stream_t stream) {
+    rw_reg32_t ifcr = (stream < DMA_STREAM_4) ? DMAx_LIFCR[instance] : DMAx_HIFCR[instance];
+    *ifcr = DMA_FLAG_ALL << dma_flag_shift(stream);
+}
+
+// Only DMAMUX1 channels 0-7 are enumerated in mmio, the DMA2 channels follow them.
+static inline rw_reg32_t dma_dmamux_channel(dma_instance_t instance, dma_stream_t stream) {
+    return DMAMUXx_CxCR[1][0] + (instance - DMA1) * DMAMUX1_CHANNELS_PER_DMA + stream;
+}
+
+static inline void dma_stream_disable(dma_instance_t instance, dma_stream_t stream) {
+    rw_reg32_t cr = dma_sxcr[stream][instance];
+    CLR_FIELD(cr, DMAx_S0CR_EN);
+    while (IS_FIELD_SET(cr, DMAx_S0CR_EN)) {}
+}
+
+// Programs the stream with the next non-empty segment of the in-flight request and
+// enables it. Returns false if there are no segments left.
+TI_FAST_CODE static bool dma_stream_next_segment(dma_instance_t instance, dma_stream_t stream) {
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    const dma_stream_req_t *req = &st->queue[st->head];
+    while (st->segment_index < req->segment_count && req->segments[st->segment_index].len == 0U) {
+        st->segment_index++;
+    }
+    if (st->segment_index >= req->segment_count) {
+        return false;
+    }
+    const dma_segment_t *seg = &req->segments[st->segment_index++];
+
+    dma_stream_disable(instance, stream);
+    dma_clear_flags(instance, stream);
+    *DMAx_SxPAR[instance][stream] = (uint32_t)req->periph;
+    *DMAx_SxM0AR[instance][stream] = (uint32_t)(uintptr_t)seg->ptr;
+    WRITE_FIELD(DMAx_SxNDTR[instance][stream], DMAx_SxNDTR_NDT, seg->len / st->item_size);
+    SET_FIELD(dma_sxcr[stream][instance], DMAx_S0CR_EN);
+    return true;
+}
+
+// Starts the request at the head of the stream's queue.
+TI_FAST_CODE static void dma_stream_launch(dma_instance_t instance, dma_stream_t stream) {
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    st->segment_index = 0U;
+
+    // MINC may only be written while the stream is disabled.
+    dma_stream_disable(instance, stream);
+    if (st->queue[st->head].mem_inc) {
+        SET_FIELD(dma_sxcr[stream][instance], DMAx_S0CR_MINC);
+    } else {
+        CLR_FIELD(dma_sxcr[stream][instance], DMAx_S0CR_MINC);
+    }
+    dma_stream_next_segment(instance, stream);
+}
+
+// Memory a request's segment covers. A fixed memory address only ever holds one data item.
+static inline size_t dma_segment_span(const dma_stream_state_t *st, const dma_stream_req_t *req,
+                                      const dma_segment_t *seg) {
+    return req->mem_inc ? seg->len : (seg->len != 0U ? st->item_size : 0U);
+}
+
+// Hands a request's memory over to the stream: data to send is written back from the data
+// cache, and receive buffers are written back and dropped from it so no dirty line can be
+// evicted over what the stream writes.
+static void dma_stream_cache_prepare(const dma_stream_state_t *st, const dma_stream_req_t *req,
+                                     const dma_segment_t *segments, size_t segment_count) {
+    for (size_t i = 0; i < segment_count; i++) {
+        size_t span = dma_segment_span(st, req, &segments[i]);
+        if (st->direction == MEM_TO_PERIPH) {
+            cache_clean(segments[i].ptr, span);
+        } else {
+            cache_clean_invalidate((void *)segments[i].ptr, span);
+        }
+    }
+}
+
+// Drops lines the core may have speculatively fetched from a receive buffer while the
+// stream was writing it. Lines the buffer shares with other data are written back first.
+static void dma_stream_cache_finish(const dma_stream_state_t *st, const dma_stream_req_t *req) {
+    if (st->direction == MEM_TO_PERIPH) {
+        return;
+    }
+    for (size_t i = 0; i < req->segment_count; i++) {
+        const dma_segment_t *seg = &req->segments[i];
+        cache_invalidate_dma((void *)seg->ptr, dma_segment_span(st, req, seg));
+    }
+}
+
+// Validates a request and adds it to the stream's queue, starting it if the stream is idle.
+static bool dma_stream_submit(dma_instance_t instance, dma_stream_t stream,
+                              const dma_stream_req_t *req) {
+    if (!dma_stream_valid(instance, stream) || req->periph == 0U ||
+        (req->segments == NULL && req->segment_count != 0U)) {
+        return false;
+    }
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    if (!st->configured) {
+        return false;
+    }
+
+    const dma_segment_t *segments = (req->segments != NULL) ? req->segments : &req->single;
+    size_t segment_count = (req->segments != NULL) ? req->segment_count : 1U;
+    size_t total = 0U;
+    for (size_t i = 0; i < segment_count; i++) {
+        size_t len = segments[i].len;
+        if (len % st->item_size != 0U || len / st->item_size > DMA_MAX_ITEMS) {
+            return false;
+        }
+        if (len != 0U && segments[i].ptr == NULL) {
+            return false;
+        }
+        total += len;
+    }
+    if (total == 0U) {
+        return false;
+    }
+    dma_stream_cache_prepare(st, req, segments, segment_count);
+
+    uint32_t primask = irq_save();
+    if (st->count == DMA_STREAM_QUEUE_LEN) {
+        irq_restore(primask);
+        return false;
+    }
+    dma_stream_req_t *slot = &st->queue[(st->head + st->count) % DMA_STREAM_QUEUE_LEN];
+    *slot = *req;
+    // Single transfers point at the copy of their segment held in the queue slot.
+    if (slot->segments == NULL) {
+        slot->segments = &slot->single;
+        slot->segment_count = 1U;
+    }
+    st->count++;
+    if (st->count == 1U) {
+        dma_stream_launch(instance, stream);
+    }
+    irq_restore(primask);
+    return true;
+}
+
+// Common stream interrupt: chains the next segment, or retires the in-flight request and
+// launches the next queued one before running the callback.
+TI_FAST_CODE static void dma_stream_irq(dma_instance_t instance, dma_stream_t stream) {
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    uint32_t flags = dma_read_flags(instance, stream);
+    dma_clear_flags(instance, stream);
+
+    bool error = (flags & DMA_FLAG_TE) != 0U;
+    if (!error && (flags & DMA_FLAG_TC) == 0U) {
+        return;
+    }
+    if (st->count == 0U) {
+        return;
+    }
+    if (!error && dma_stream_next_segment(instance, stream)) {
+        return;
+    }
+
+    dma_stream_cache_finish(st, &st->queue[st->head]);
+    void *context = st->queue[st->head].context;
+    st->head = (st->head + 1U) % DMA_STREAM_QUEUE_LEN;
+    st->count--;
+    if (st->count != 0U) {
+        dma_stream_launch(instance, stream);
+    } else {
+        dma_stream_disable(instance, stream);
+    }
+
+    if (st->callback != NULL) {
+        st->callback(!error, context);
+    }
+}
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
 tal_err_t *dma_init(void) {
+    SET_FIELD(RCC_AHB1ENR, RCC_AHB1ENR_DMAxEN[DMA1]);
+    SET_FIELD(RCC_AHB1ENR, RCC_AHB1ENR_DMAxEN[DMA2]);
+    SET_FIELD(RCC_AHB3ENR, RCC_AHB3ENR_MDMAEN);
+
+    // Memory engine channel: highest priority, interrupt on completion and error.
+    const int ch = MDMA_MEM_CHANNEL;
+    *MDMA_MDMA_CxCR[ch] = 0U;
+    *MDMA_MDMA_CxIFCR[ch] = MDMA_IFCR_ALL;
+    WRITE_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_PL, 3U);
+    SET_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_TEIE);
+    SET_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_CTCIE);
+
+    // Peripheral channel: below the memory engine, so bulk copies cannot starve a
+    // peripheral FIFO.
+    *MDMA_MDMA_CxCR[MDMA_PERIPH_CHANNEL] = 0U;
+    *MDMA_MDMA_CxIFCR[MDMA_PERIPH_CHANNEL] = MDMA_IFCR_ALL;
+    WRITE_FIELD(MDMA_MDMA_CxCR[MDMA_PERIPH_CHANNEL], MDMA_MDMA_CxCR_PL, 2U);
+    SET_FIELD(MDMA_MDMA_CxCR[MDMA_PERIPH_CHANNEL], MDMA_MDMA_CxCR_TEIE);
+    SET_FIELD(MDMA_MDMA_CxCR[MDMA_PERIPH_CHANNEL], MDMA_MDMA_CxCR_CTCIE);
+    periph_busy = false;
+
+    irq_set_priority(MDMA_IRQ_NUM, DMA_IRQ_PRIORITY);
+    irq_enable(MDMA_IRQ_NUM);
+
+    mem_head = 0U;
+    mem_count = 0U;
+    mem_ready = true;
     return (void*) (0);
 }
 
 bool dma_configure_stream(const dma_config_t* config) {
-    return 1;
+    if (config == NULL || !dma_stream_valid(config->instance, config->stream) ||
+        config->direction >= DMA_DIR_COUNT ||
+        config->src_data_size >= DMA_DATA_SIZE_COUNT ||
+        config->dest_data_size >= DMA_DATA_SIZE_COUNT ||
+        config->priority >= DMA_PRIORITY_COUNT ||
+        config->fifo_threshold >= DMA_FIFO_THRESHOLD_COUNT) {
+        return false;
+    }
+    dma_instance_t instance = config->instance;
+    dma_stream_t stream = config->stream;
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    if (st->count != 0U) {
+        return false;
+    }
+
+    SET_FIELD(RCC_AHB1ENR, RCC_AHB1ENR_DMAxEN[instance]);
+    dma_stream_disable(instance, stream);
+    dma_clear_flags(instance, stream);
+
+    WRITE_FIELD(dma_dmamux_channel(instance, stream), DMAMUXx_CxCR_DMAREQ_ID, config->request_id);
+
+    bool to_periph = (config->direction == MEM_TO_PERIPH);
+    dma_data_size_t periph_size = to_periph ? config->dest_data_size : config->src_data_size;
+    dma_data_size_t mem_size = to_periph ? config->src_data_size : config->dest_data_size;
+    *dma_sxcr[stream][instance] = TO_FIELD(to_periph ? 1U : 0U, DMAx_S0CR_DIR)
+                                | TO_FIELD((uint32_t)periph_size, DMAx_S0CR_PSIZE)
+                                | TO_FIELD((uint32_t)mem_size, DMAx_S0CR_MSIZE)
+                                | TO_FIELD((uint32_t)config->priority, DMAx_S0CR_PL)
+                                | TO_FIELD(config->bufferable ? 1U : 0U, DMAx_S0CR_TRBUFF)
+                                | DMAx_S0CR_MINC.msk
+                                | DMAx_S0CR_TCIE.msk
+                                | DMAx_S0CR_TEIE.msk;
+
+    // FTH counts up from a quarter, the threshold enum counts down from full.
+    if (config->fifo_enabled) {
+        *DMAx_SxFCR[instance][stream] = DMAx_SxFCR_DMDIS.msk |
+            TO_FIELD(3U - (uint32_t)config->fifo_threshold, DMAx_SxFCR_FTH);
+    } else {
+        *DMAx_SxFCR[instance][stream] = 0U;
+    }
+
+    st->direction = config->direction;
+    st->item_size = 1U << periph_size;
+    st->callback = config->callback;
+    st->configured = true;
+
+    int32_t irq = DMAx_STRx_IRQ_NUM[instance][stream];
+    irq_set_priority(irq, DMA_IRQ_PRIORITY);
+    irq_enable(irq);
+    return true;
 }
 inline static bool check_periph_dma_config_validity(periph_dma_config_t *dma_config) {
     return 1;
 }
 
 bool dma_start_transfer( dma_transfer_t *dma_transfer) {
-    return 1;
-}
\ No newline at end of file
+    if (dma_transfer == NULL || !dma_stream_valid(dma_transfer->instance, dma_transfer->stream)) {
+        return false;
+    }
+    const dma_stream_state_t *st = &stream_state[dma_transfer->instance][dma_transfer->stream];
+    bool to_periph = (st->direction == MEM_TO_PERIPH);
+    dma_stream_req_t req = {
+        .periph = (uintptr_t)(to_periph ? dma_transfer->dest : dma_transfer->src),
+        .segments = NULL,
+        .segment_count = 0U,
+        .single = {
+            .ptr = to_periph ? dma_transfer->src : dma_transfer->dest,
+            .len = dma_transfer->size,
+        },
+        .context = dma_transfer->context,
+        .mem_inc = !dma_transfer->disable_mem_inc,
+    };
+    return dma_stream_submit(dma_transfer->instance, dma_transfer->stream, &req);
+}
+
+bool dma_start_transfer_sg(const dma_sg_transfer_t *sg_transfer) {
+    if (sg_transfer == NULL || sg_transfer->segments == NULL || sg_transfer->segment_count == 0U) {
+        return false;
+    }
+    dma_stream_req_t req = {
+        .periph = (uintptr_t)sg_transfer->periph,
+        .segments = sg_transfer->segments,
+        .segment_count = sg_transfer->segment_count,
+        .context = sg_transfer->context,
+        .mem_inc = true,
+    };
+    return dma_stream_submit(sg_transfer->instance, sg_transfer->stream, &req);
+}
+
+bool dma_stream_busy(dma_instance_t instance, dma_stream_t stream) {
+    if (!dma_stream_valid(instance, stream)) {
+        return false;
+    }
+    return stream_state[instance][stream].count != 0U;
+}
+
+bool dma_stream_abort(dma_instance_t instance, dma_stream_t stream) {
+    if (!dma_stream_valid(instance, stream)) {
+        return false;
+    }
+    dma_stream_state_t *st = &stream_state[instance][stream];
+    uint32_t primask = irq_save();
+    if (st->count == 0U) {
+        irq_restore(primask);
+        return false;
+    }
+    dma_stream_disable(instance, stream);
+    dma_clear_flags(instance, stream);
+    irq_clear_pending(DMAx_STRx_IRQ_NUM[instance][stream]);
+    dma_stream_cache_finish(st, &st->queue[st->head]);
+    st->head = (st->head + 1U) % DMA_STREAM_QUEUE_LEN;
+    st->count--;
+    if (st->count != 0U) {
+        dma_stream_launch(instance, stream);
+    }
+    irq_restore(primask);
+    return true;
+}
+
+bool dma_memcpy(void *dest, const void *src, size_t size, dma_callback_t callback, void *context) {
+    if (src == NULL) {
+        return false;
+    }
+    mdma_mem_req_t req = {
+        .dest = dest,
+        .src = src,
+        .size = size,
+        .fill = 0U,
+        .callback = callback,
+        .context = context,
+    };
+    return mdma_submit(&req);
+}
+
+bool dma_memset(void *dest, uint8_t value, size_t size, dma_callback_t callback, void *context) {
+    mdma_mem_req_t req = {
+        .dest = dest,
+        .src = NULL,
+        .size = size,
+        .fill = value,
+        .callback = callback,
+        .context = context,
+    };
+    return mdma_submit(&req);
+}
+
+bool dma_mem_busy(void) {
+    return mem_count != 0U;
+}
+
+bool dma_mdma_periph_start(const dma_mdma_periph_transfer_t *transfer) {
+    if (!mem_ready || transfer == NULL || transfer->periph == NULL || transfer->mem == NULL ||
+        transfer->size == 0U || transfer->size > DMA_MDMA_MAX_BLOCK ||
+        transfer->burst == 0U || transfer->burst > MDMA_TLEN_MAX + 1U) {
+        return false;
+    }
+    uint32_t primask = irq_save();
+    if (periph_busy) {
+        irq_restore(primask);
+        return false;
+    }
+    periph_busy = true;
+    periph_callback = transfer->callback;
+    periph_context = transfer->context;
+    periph_rx_mem = transfer->to_periph ? NULL : transfer->mem;
+    periph_rx_size = transfer->size;
+    irq_restore(primask);
+
+    if (transfer->to_periph) {
+        cache_clean(transfer->mem, transfer->size);
+    } else {
+        cache_clean_invalidate(transfer->mem, transfer->size);
+    }
+
+    // The peripheral side stays on its data register, the memory side walks the buffer.
+    uintptr_t mem = (uintptr_t)transfer->mem;
+    uintptr_t periph = (uintptr_t)transfer->periph;
+    uintptr_t src = transfer->to_periph ? mem : periph;
+    uintptr_t dst = transfer->to_periph ? periph : mem;
+    uint32_t mem_inc = MDMA_INC_UP;
+    uint32_t periph_inc = MDMA_INC_FIXED;
+    uint32_t tcr = TO_FIELD(transfer->to_periph ? mem_inc : periph_inc, MDMA_MDMA_CxTCR_SINC)
+                 | TO_FIELD(transfer->to_periph ? periph_inc : mem_inc, MDMA_MDMA_CxTCR_DINC)
+                 | TO_FIELD(MDMA_SIZE_BYTE, MDMA_MDMA_CxTCR_SSIZE)
+                 | TO_FIELD(MDMA_SIZE_BYTE, MDMA_MDMA_CxTCR_DSIZE)
+                 | TO_FIELD(MDMA_SIZE_BYTE, MDMA_MDMA_CxTCR_SINCOS)
+                 | TO_FIELD(MDMA_SIZE_BYTE, MDMA_MDMA_CxTCR_DINCOS)
+                 | TO_FIELD(transfer->burst - 1U, MDMA_MDMA_CxTCR_TLEN)
+                 | TO_FIELD(MDMA_TRGM_BUFFER, MDMA_MDMA_CxTCR_TRGM);
+    uint32_t tbr = TO_FIELD(transfer->request, MDMA_MDMA_CxTBR_TSEL)
+                 | (mdma_is_tcm(src) ? MDMA_MDMA_CxTBR_SBUS.msk : 0U)
+                 | (mdma_is_tcm(dst) ? MDMA_MDMA_CxTBR_DBUS.msk : 0U);
+
+    const int ch = MDMA_PERIPH_CHANNEL;
+    CLR_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    *MDMA_MDMA_CxIFCR[ch] = MDMA_IFCR_ALL;
+    *MDMA_MDMA_CxTCR[ch] = tcr;
+    *MDMA_MDMA_CxBNDTR[ch] = TO_FIELD((uint32_t)transfer->size, MDMA_MDMA_CxBNDTR_BNDT);
+    *MDMA_MDMA_CxSAR[ch] = (uint32_t)src;
+    *MDMA_MDMA_CxDAR[ch] = (uint32_t)dst;
+    *MDMA_MDMA_CxTBR[ch] = tbr;
+    *MDMA_MDMA_CxLAR[ch] = 0U;
+    SET_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    return true;
+}
+
+void dma_mdma_periph_abort(void) {
+    CLR_FIELD(MDMA_MDMA_CxCR[MDMA_PERIPH_CHANNEL], MDMA_MDMA_CxCR_EN);
+    *MDMA_MDMA_CxIFCR[MDMA_PERIPH_CHANNEL] = MDMA_IFCR_ALL;
+    periph_busy = false;
+}
+
+/**************************************************************************************************
+ * @section Interrupt Handlers
+ **************************************************************************************************/
+TI_FAST_CODE void dma_str0_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_0); }
+TI_FAST_CODE void dma_str1_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_1); }
+TI_FAST_CODE void dma_str2_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_2); }
+TI_FAST_CODE void dma_str3_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_3); }
+TI_FAST_CODE void dma_str4_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_4); }
+TI_FAST_CODE void dma_str5_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_5); }
+TI_FAST_CODE void dma_str6_irq_handler(void)  { dma_stream_irq(DMA1, DMA_STREAM_6); }
+TI_FAST_CODE void dma1_str7_irq_handler(void) { dma_stream_irq(DMA1, DMA_STREAM_7); }
+TI_FAST_CODE void dma2_str0_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_0); }
+TI_FAST_CODE void dma2_str1_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_1); }
+TI_FAST_CODE void dma2_str2_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_2); }
+TI_FAST_CODE void dma2_str3_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_3); }
+TI_FAST_CODE void dma2_str4_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_4); }
+TI_FAST_CODE void dma2_str5_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_5); }
+TI_FAST_CODE void dma2_str6_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_6); }
+TI_FAST_CODE void dma2_str7_irq_handler(void) { dma_stream_irq(DMA2, DMA_STREAM_7); }
+
+static void mdma_periph_irq(void) {
+    const int ch = MDMA_PERIPH_CHANNEL;
+    bool error = IS_FIELD_SET(MDMA_MDMA_CxISR[ch], MDMA_MDMA_C0ISR_TEIF0);
+    bool done = IS_FIELD_SET(MDMA_MDMA_CxISR[ch], MDMA_MDMA_C0ISR_CTCIF0);
+    if (!error && !done) {
+        return;
+    }
+    *MDMA_MDMA_CxIFCR[ch] = MDMA_IFCR_ALL;
+    if (error) {
+        CLR_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    }
+    if (!periph_busy) {
+        return;
+    }
+    periph_busy = false;
+    if (periph_rx_mem != NULL) {
+        cache_invalidate_dma(periph_rx_mem, periph_rx_size);
+    }
+    if (periph_callback != NULL) {
+        periph_callback(!error, periph_context);
+    }
+}
+
+void mdma_irq_handler(void) {
+    mdma_periph_irq();
+
+    const int ch = MDMA_MEM_CHANNEL;
+    bool error = IS_FIELD_SET(MDMA_MDMA_CxISR[ch], MDMA_MDMA_C0ISR_TEIF0);
+    bool done = IS_FIELD_SET(MDMA_MDMA_CxISR[ch], MDMA_MDMA_C0ISR_CTCIF0);
+    if (!error && !done) {
+        return;
+    }
+    *MDMA_MDMA_CxIFCR[ch] = MDMA_IFCR_ALL;
+    if (mem_count == 0U) {
+        return;
+    }
+
+    const mdma_mem_req_t *req = &mem_queue[mem_head];
+    if (!error) {
+        mem_offset += mem_chunk;
+        if (mem_offset < req->size) {
+            mdma_launch_block();
+            return;
+        }
+    } else {
+        CLR_FIELD(MDMA_MDMA_CxCR[ch], MDMA_MDMA_CxCR_EN);
+    }
+
+    // Drop lines of the destination fetched while the copy ran.
+    cache_invalidate_dma(req->dest, req->size);
+
+    // Retire the request and start the next one before running the callback, so the
+    // engine stays busy while the callback executes.
+    dma_callback_t callback = req->callback;
+    void *context = req->context;
+    mem_head = (mem_head + 1U) % DMA_MEM_QUEUE_LEN;
+    mem_count--;
+    mem_offset = 0U;
+    if (mem_count != 0U) {
+        mdma_launch_block();
+    }
+
+    if (callback != NULL) {
+        callback(!error, context);
+    }
+}
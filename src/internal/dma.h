@@ -20,9 +20,30 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "../util/error.h"
 
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+// Maximum number of memory operations that can be pending on the MDMA copy engine.
+#define DMA_MEM_QUEUE_LEN 16
+
+// Maximum number of transfers that can be pending on a single DMA1/2 stream.
+#define DMA_STREAM_QUEUE_LEN 8
+
+// Memory operations smaller than this (in bytes) are performed by the CPU when the copy
+// engine is idle, since the MDMA setup and completion interrupt cost more than the copy.
+#define DMA_MEM_CPU_THRESHOLD 64
+
+// Largest transfer the MDMA peripheral channel moves at once (one block, BNDT is 17 bits).
+#define DMA_MDMA_MAX_BLOCK 0x10000U
+
+// MDMA hardware requests (TSEL) for peripherals that are only served by the MDMA.
+#define DMA_MDMA_REQ_QUADSPI_FIFO 22U
+
 /**************************************************************************************************
  * @section Type Definitions
  **************************************************************************************************/
@@ -100,6 +121,7 @@ typedef struct {
     bool             fifo_enabled;   // Generally disabled for sending instructions to peripherals,
                                         // but enabled for high-throughput transfers
     dma_fifo_threshold_t fifo_threshold; // FIFO threshold for DMA1/2 (e.g., DMA_FIFO_THRESHOLD_FULL)
+    bool             bufferable;     // Sets TRBUFF, which RM0399 requires for U(S)ART requests
     // Callback for this stream
     dma_callback_t   callback;
 } dma_config_t;
@@ -139,6 +161,31 @@ typedef struct {
     bool disable_mem_inc; // Useful for dummy spi transactions
 } dma_transfer_t;
 
+/**
+ * @brief One contiguous memory segment of a scatter-gather transfer.
+ *
+ * For PERIPH_TO_MEM streams the segment is written to, despite the const qualifier.
+ */
+typedef struct {
+    const void *ptr;
+    size_t len;   // In bytes. Zero length segments are skipped.
+} dma_segment_t;
+
+/**
+ * @brief DMA scatter-gather transfer config
+ *
+ * Moves a list of memory segments to (or from) a single peripheral address as one logical
+ * transfer. The stream callback is invoked once, after the last segment completes.
+ */
+typedef struct {
+    dma_instance_t instance;
+    dma_stream_t stream;
+    void *periph;                   // Peripheral data register
+    const dma_segment_t *segments;  // Must remain valid until the callback is invoked
+    size_t segment_count;
+    void *context;
+} dma_sg_transfer_t;
+
 // Used to track rx/tx stream/instance for peripheral instances
 typedef struct {
     dma_instance_t rx_instance; // TODO: Perhaps simplify this so only one instance
@@ -147,6 +194,21 @@ typedef struct {
     dma_stream_t tx_stream;
 } dma_periph_streaminfo_t;
 
+/**
+ * @brief A transfer on the MDMA peripheral channel, paced by a peripheral's hardware request.
+ * Each request moves @p burst bytes, so it should match the peripheral's FIFO threshold.
+ */
+typedef struct {
+    uint32_t request;       // MDMA hardware request, e.g. DMA_MDMA_REQ_QUADSPI_FIFO
+    volatile void *periph;  // Peripheral data register, accessed a byte at a time
+    void *mem;              // Memory side buffer
+    size_t size;            // In bytes, at most DMA_MDMA_MAX_BLOCK
+    uint32_t burst;         // Bytes per hardware request, 1-128
+    bool to_periph;         // true for memory to peripheral
+    dma_callback_t callback; // Invoked from the MDMA interrupt on completion. May be NULL.
+    void *context;
+} dma_mdma_periph_transfer_t;
+
 /**************************************************************************************************
 * @section Public Functions
 **************************************************************************************************/
@@ -165,14 +227,17 @@ tal_err_t *dma_init(void);
 bool dma_configure_stream(const dma_config_t* config);
 
 /**
- * @brief Starts a DMA transfer for the specified stream.
- * This function initiates the transfer based on the previously configured settings.
+ * @brief Queues a DMA transfer on the specified stream.
+ * The transfer starts immediately if the stream is idle. Otherwise it is started from the
+ * completion interrupt of the previous transfer, so the peripheral sees a gap of one
+ * interrupt latency between them. The stream callback runs once per transfer, in
+ * submission order.
  * @param instance The DMA instance (DMA1, DMA2, MDMA, BDMA).
  * @param stream The specific stream to start.
  * @param src Pointer to the source data buffer.
  * @param dest Pointer to the destination data buffer.
  * @param size Number of bytes to transfer.
- * @return bool, whether the transfer was successfully started.
+ * @return bool, whether the transfer was queued (false if invalid or the queue is full).
  */
 bool dma_start_transfer( dma_transfer_t *dma_transfer);
 
@@ -181,4 +246,81 @@ bool dma_start_transfer( dma_transfer_t *dma_transfer);
  * @param config The config to check.
  * @return bool Whether the config is valid.
  */
-inline static bool check_periph_dma_config_validity(periph_dma_config_t *dma_config);
\ No newline at end of file
+inline static bool check_periph_dma_config_validity(periph_dma_config_t *dma_config);
+
+/**
+ * @brief Queues a scatter-gather DMA transfer on the specified stream.
+ * Segments are chained in software from the stream's completion interrupt, and the callback
+ * runs once at the end. The stream is idle between segments for one interrupt latency, so
+ * a PERIPH_TO_MEM transfer from a peripheral that does not hold off its sender (e.g. a UART
+ * without flow control) can overrun at segment boundaries.
+ * Shares the stream queue with dma_start_transfer().
+ * @param sg_transfer The scatter-gather transfer to queue.
+ * @return bool, whether the transfer was queued.
+ */
+bool dma_start_transfer_sg(const dma_sg_transfer_t *sg_transfer);
+
+/**
+ * @brief Checks whether a stream has transfers in flight or queued.
+ * @param instance The DMA instance.
+ * @param stream The stream to check.
+ * @return bool, true if the stream's queue is non-empty.
+ */
+bool dma_stream_busy(dma_instance_t instance, dma_stream_t stream);
+
+/**
+ * @brief Stops a stream and drops the transfer in flight on it, without invoking its callback.
+ * The next queued transfer, if any, is started.
+ * For peripheral drivers ending a job early, e.g. after the job's other stream failed.
+ * @param instance The DMA instance.
+ * @param stream The stream to abort.
+ * @return bool, true if a transfer was dropped.
+ */
+bool dma_stream_abort(dma_instance_t instance, dma_stream_t stream);
+
+/**
+ * @brief Asynchronously copies a block of memory using the MDMA.
+ * Requests are queued and executed in submission order. If the engine is idle and the
+ * request is smaller than DMA_MEM_CPU_THRESHOLD, the copy is performed by the CPU and the
+ * callback is invoked before this function returns.
+ * @param dest Destination buffer. Must not be modified until the callback is invoked.
+ * @param src Source buffer. Must not overlap with dest.
+ * @param size Number of bytes to copy.
+ * @param callback Invoked (from interrupt context for MDMA transfers) on completion. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if the request was accepted, false if the arguments are invalid, the
+ *         queue is full, or dma_init() has not been called.
+ */
+bool dma_memcpy(void *dest, const void *src, size_t size, dma_callback_t callback, void *context);
+
+/**
+ * @brief Asynchronously fills a block of memory with a byte value using the MDMA.
+ * Follows the same queueing and CPU fallback rules as dma_memcpy().
+ * @param dest Destination buffer.
+ * @param value Byte value to write.
+ * @param size Number of bytes to fill.
+ * @param callback Invoked on completion. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if the request was accepted, false otherwise.
+ */
+bool dma_memset(void *dest, uint8_t value, size_t size, dma_callback_t callback, void *context);
+
+/**
+ * @brief Checks whether the MDMA copy engine has pending or in-flight requests.
+ * @return true if any memory operation is still outstanding.
+ */
+bool dma_mem_busy(void);
+
+/**
+ * @brief Starts a transfer on the MDMA peripheral channel.
+ * The channel serves one transfer at a time; its owner is expected to sequence them.
+ * @param transfer Transfer description. Only read during this call.
+ * @return true if the transfer was started, false if the arguments are invalid, the channel
+ *         is busy, or dma_init() has not been called.
+ */
+bool dma_mdma_periph_start(const dma_mdma_periph_transfer_t *transfer);
+
+/**
+ * @brief Stops the transfer on the MDMA peripheral channel without invoking its callback.
+ */
+void dma_mdma_periph_abort(void);
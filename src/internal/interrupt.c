@@ -20,6 +20,7 @@
  */
 
 #include "interrupt.h"
+#include "mmio.h"
 
 /**************************************************************************************************
  * @section Miscellaneous Constants
@@ -278,3 +279,119 @@ const int32_t FDCANx_ITx_IRQ_NUM[3][2] = {
     [1] = 22,
   },
 };
+
+/**************************************************************************************************
+ * @section NVIC Utility Implementations
+ **************************************************************************************************/
+
+/** @brief Key that has to accompany every write to SCB_AIRCR. */
+#define AIRCR_VECTKEY 0x05FAU
+
+/** @brief Lowest exception number with a configurable priority. */
+#define SHPR_FIRST_EXC_NUM 4
+
+static bool irq_valid(int32_t irq) {
+  return irq >= 0 && irq < IRQ_COUNT;
+}
+
+/* Priorities are held in the top NVIC_PRIO_BITS bits of each 8 bit priority field. */
+static uint32_t irq_prio_to_field(uint32_t priority) {
+  if (priority >= (uint32_t)NVIC_MAX_PRIO) {
+    priority = (uint32_t)NVIC_MAX_PRIO - 1U;
+  }
+  return priority << (8 - NVIC_PRIO_BITS);
+}
+
+void irq_enable(int32_t irq) {
+  if (irq_valid(irq)) {
+    *NVIC_ISERx[irq / 32] = 1U << (irq % 32);
+  }
+}
+
+void irq_disable(int32_t irq) {
+  if (irq_valid(irq)) {
+    *NVIC_ICERx[irq / 32] = 1U << (irq % 32);
+#if defined(__arm__)
+    /* Make sure the write has reached the NVIC before the caller relies on it. */
+    __asm__ volatile ("dsb\n\tisb" ::: "memory");
+#endif
+  }
+}
+
+bool irq_is_enabled(int32_t irq) {
+  return irq_valid(irq) && (*NVIC_ISERx[irq / 32] & (1U << (irq % 32)));
+}
+
+void irq_set_pending(int32_t irq) {
+  if (irq_valid(irq)) {
+    *NVIC_ISPRx[irq / 32] = 1U << (irq % 32);
+  }
+}
+
+void irq_clear_pending(int32_t irq) {
+  if (irq_valid(irq)) {
+    *NVIC_ICPRx[irq / 32] = 1U << (irq % 32);
+  }
+}
+
+bool irq_get_pending(int32_t irq) {
+  return irq_valid(irq) && (*NVIC_ISPRx[irq / 32] & (1U << (irq % 32)));
+}
+
+bool irq_get_active(int32_t irq) {
+  return irq_valid(irq) && (*NVIC_IABRx[irq / 32] & (1U << (irq % 32)));
+}
+
+/* The priority registers are byte accessible, so a field can be written without touching (or
+ * racing with) the other IRQs that share its register. */
+void irq_set_priority(int32_t irq, uint32_t priority) {
+  if (irq_valid(irq)) {
+    volatile uint8_t *ipr = (volatile uint8_t *)NVIC_IPRx[0];
+    ipr[irq] = (uint8_t)irq_prio_to_field(priority);
+  }
+}
+
+uint32_t irq_get_priority(int32_t irq) {
+  if (!irq_valid(irq)) {
+    return 0U;
+  }
+  return READ_FIELD(NVIC_IPRx[irq / 4], NVIC_IPRx_IPR_Nx[irq % 4]) >> (8 - NVIC_PRIO_BITS);
+}
+
+void exc_set_priority(int32_t exc_num, uint32_t priority) {
+  if (exc_num >= SHPR_FIRST_EXC_NUM && exc_num <= SYSTICK_EXC_NUM) {
+    volatile uint8_t *shpr = (volatile uint8_t *)SCB_SHPR1;
+    shpr[exc_num - SHPR_FIRST_EXC_NUM] = (uint8_t)irq_prio_to_field(priority);
+  }
+}
+
+void irq_set_priority_grouping(uint32_t preempt_bits) {
+  if (preempt_bits > (uint32_t)NVIC_PRIO_BITS) {
+    preempt_bits = (uint32_t)NVIC_PRIO_BITS;
+  }
+  /* PRIGROUP is the index of the highest subpriority bit in the 8 bit field, and the
+   * implemented bits are the top NVIC_PRIO_BITS of it. */
+  uint32_t aircr = *SCB_AIRCR & (SCB_AIRCR_ENDIANESS.msk);
+  aircr |= (AIRCR_VECTKEY << SCB_AIRCR_VECTKEYSTAT.pos);
+  aircr |= ((7U - preempt_bits) << SCB_AIRCR_PRIGROUP.pos) & SCB_AIRCR_PRIGROUP.msk;
+  *SCB_AIRCR = aircr;
+}
+
+uint32_t irq_get_priority_grouping(void) {
+  uint32_t prigroup = READ_FIELD(SCB_AIRCR, SCB_AIRCR_PRIGROUP);
+  uint32_t preempt_bits = 7U - prigroup;
+  return preempt_bits > (uint32_t)NVIC_PRIO_BITS ? (uint32_t)NVIC_PRIO_BITS : preempt_bits;
+}
+
+uint32_t irq_encode_priority(uint32_t group, uint32_t sub) {
+  uint32_t sub_bits = (uint32_t)NVIC_PRIO_BITS - irq_get_priority_grouping();
+  uint32_t group_max = (1U << ((uint32_t)NVIC_PRIO_BITS - sub_bits)) - 1U;
+  uint32_t sub_max = (1U << sub_bits) - 1U;
+  if (group > group_max) {
+    group = group_max;
+  }
+  if (sub > sub_max) {
+    sub = sub_max;
+  }
+  return (group << sub_bits) | sub;
+}
@@ -20,6 +20,7 @@
  */
 
 #pragma once
+#include <stdbool.h>
 #include <stdint.h>
 
 /**************************************************************************************************
@@ -317,4 +318,158 @@ extern const int32_t USARTx_IRQ_NUM[7];         /** @brief USART global interrup
 extern const int32_t UARTx_IRQ_NUM[9];          /** @brief UART global interrupt. */
 extern const int32_t TIMx_CC_IRQ_NUM[9];        /** @brief TIM capture/compare global interrupt. */
 extern const int32_t DMAx_STRx_IRQ_NUM[3][8];   /** @brief DMA1 stream x interrupt. */
-extern const int32_t FDCANx_ITx_IRQ_NUM[3][2];  /** @brief FDCAN1 interrupt x. */
\ No newline at end of file
+extern const int32_t FDCANx_ITx_IRQ_NUM[3][2];  /** @brief FDCAN1 interrupt x. */
+/**************************************************************************************************
+ * @section Interrupt Masking Utilities
+ **************************************************************************************************/
+
+/**
+ * @brief Masks all configurable interrupts on the calling core.
+ * @returns (uint32_t) The value of PRIMASK before interrupts were masked.
+ * @note - Must be paired with a call to irq_restore() using the returned value,
+ *         which allows critical sections to be nested safely.
+ */
+static inline uint32_t irq_save(void) {
+  uint32_t primask;
+  __asm__ volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+  return primask;
+}
+
+/**
+ * @brief Restores the interrupt mask state saved by irq_save().
+ * @param primask (uint32_t) The value returned by the matching call to irq_save().
+ */
+static inline void irq_restore(uint32_t primask) {
+  __asm__ volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/**************************************************************************************************
+ * @section NVIC Utilities
+ **************************************************************************************************/
+
+/**
+ * @brief Enables an IRQ in the NVIC.
+ * @param irq (int32_t) The IRQ number (see the IRQ numbers above).
+ * @note - Out of range IRQ numbers are ignored by all of the functions in this section.
+ */
+void irq_enable(int32_t irq);
+
+/**
+ * @brief Disables an IRQ in the NVIC.
+ * @param irq (int32_t) The IRQ number.
+ * @note - The IRQ can no longer be taken once this returns.
+ */
+void irq_disable(int32_t irq);
+
+/**
+ * @brief Checks whether an IRQ is enabled in the NVIC.
+ * @param irq (int32_t) The IRQ number.
+ * @returns (bool) True if the IRQ is enabled.
+ */
+bool irq_is_enabled(int32_t irq);
+
+/**
+ * @brief Marks an IRQ as pending, so its handler runs as if the peripheral raised it.
+ * @param irq (int32_t) The IRQ number.
+ */
+void irq_set_pending(int32_t irq);
+
+/**
+ * @brief Clears the pending state of an IRQ.
+ * @param irq (int32_t) The IRQ number.
+ */
+void irq_clear_pending(int32_t irq);
+
+/**
+ * @brief Checks whether an IRQ is pending.
+ * @param irq (int32_t) The IRQ number.
+ * @returns (bool) True if the IRQ is pending.
+ */
+bool irq_get_pending(int32_t irq);
+
+/**
+ * @brief Checks whether the handler of an IRQ is running (or has been pre-empted).
+ * @param irq (int32_t) The IRQ number.
+ * @returns (bool) True if the IRQ is active.
+ */
+bool irq_get_active(int32_t irq);
+
+/**
+ * @brief Sets the priority of an IRQ.
+ * @param irq (int32_t) The IRQ number.
+ * @param priority (uint32_t) The priority, from 0 (highest) to NVIC_MAX_PRIO - 1 (lowest).
+ *                 Use irq_encode_priority() to build a value from a group and subpriority.
+ */
+void irq_set_priority(int32_t irq, uint32_t priority);
+
+/**
+ * @brief Gets the priority of an IRQ.
+ * @param irq (int32_t) The IRQ number.
+ * @returns (uint32_t) The priority, in the same form as passed to irq_set_priority().
+ */
+uint32_t irq_get_priority(int32_t irq);
+
+/**
+ * @brief Sets the priority of a configurable system exception.
+ * @param exc_num (int32_t) The exception number, from MEM_MANAGE_EXC_NUM to SYSTICK_EXC_NUM.
+ * @param priority (uint32_t) The priority, from 0 (highest) to NVIC_MAX_PRIO - 1 (lowest).
+ */
+void exc_set_priority(int32_t exc_num, uint32_t priority);
+
+/**
+ * @brief Sets how the priority bits are split between group priority and subpriority.
+ * @param preempt_bits (uint32_t) Number of the NVIC_PRIO_BITS priority bits that form the group
+ *                     priority. Only an interrupt with a higher group priority can pre-empt a
+ *                     running handler; the subpriority only orders pending interrupts.
+ * @note - Values above NVIC_PRIO_BITS are clamped. The reset value is NVIC_PRIO_BITS (every
+ *         priority level can pre-empt the levels below it).
+ */
+void irq_set_priority_grouping(uint32_t preempt_bits);
+
+/**
+ * @brief Gets the number of priority bits that form the group priority.
+ * @returns (uint32_t) The value last set by irq_set_priority_grouping().
+ */
+uint32_t irq_get_priority_grouping(void);
+
+/**
+ * @brief Builds a priority value for the current priority grouping.
+ * @param group (uint32_t) The group (pre-emption) priority, 0 being the highest.
+ * @param sub (uint32_t) The subpriority within the group, 0 being the highest.
+ * @returns (uint32_t) The priority, to be passed to irq_set_priority() or exc_set_priority().
+ */
+uint32_t irq_encode_priority(uint32_t group, uint32_t sub);
+
+/**************************************************************************************************
+ * @section Vector Table Utilities
+ **************************************************************************************************/
+
+/** @brief Interrupt/exception handler function. */
+typedef void (*irq_handler_t)(void);
+
+/**
+ * @brief Copies the calling core's vector table from flash into RAM (DTCM on the CM7, SRAM4 on
+ *        the CM4) and points SCB_VTOR at the copy.
+ * @note - Vector fetches from DTCM have no wait states, which shortens every exception entry.
+ *       - Called from the CM7 reset handler when TI_RAM_VTABLE is defined, and otherwise by
+ *         the first call to irq_attach(). Always called by the CM4 reset handler, since the
+ *         CM4 flash table only holds its core specific vectors. Calling it again has no effect.
+ */
+void irq_relocate_vtable(void);
+
+/**
+ * @brief Installs a handler for an IRQ at runtime, replacing the one bound at link time.
+ * @param irq (int32_t) The IRQ number.
+ * @param handler (irq_handler_t) The new handler.
+ * @returns (bool) True if the handler was installed, false if the arguments are invalid.
+ * @note - Relocates the vector table (see irq_relocate_vtable()) if that has not happened yet.
+ *       - The IRQ should be disabled while its handler is replaced.
+ */
+bool irq_attach(int32_t irq, irq_handler_t handler);
+
+/**
+ * @brief Restores the handler an IRQ had at link time.
+ * @param irq (int32_t) The IRQ number.
+ * @returns (bool) True on success, false if the IRQ number is invalid.
+ */
+bool irq_detach(int32_t irq);
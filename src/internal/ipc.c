@@ -0,0 +1,179 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/ipc.c
+ * @authors Charles Faisandier
+ * @brief Inter-core message queues.
+ */
+
+#include "ipc.h"
+#include "cm4.h"
+#include "interrupt.h"
+#include "mmio.h"
+#include "sections.h"
+#include <stddef.h>
+#include <string.h>
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+
+#define SRAM4_BASE 0x38000000U
+#define SRAM4_SIZE 0x10000U
+
+#define HSEM_SEM_COUNT 32U
+
+// HSEM core IDs.
+#define HSEM_COREID_CM4 1U
+#define HSEM_COREID_CM7 3U
+
+// Queue with a callback for each semaphore, shared so each core finds the queues it consumes.
+static TI_SHARED ipc_queue_t *volatile ipc_queues[HSEM_SEM_COUNT];
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+
+static inline void ipc_dmb(void) {
+  __asm__ volatile ("dmb" ::: "memory");
+}
+
+static bool ipc_in_sram4(const void *ptr, size_t size) {
+  uintptr_t addr = (uintptr_t)ptr;
+  return addr >= SRAM4_BASE && size <= SRAM4_SIZE && addr - SRAM4_BASE <= SRAM4_SIZE - size;
+}
+
+// Takes and frees the queue's semaphore, which raises the HSEM interrupt on every core that
+// enabled it, then signals an event for a core waiting in ipc_wait().
+static void ipc_notify(const ipc_queue_t *queue) {
+  __asm__ volatile ("dsb" ::: "memory"); // The new head is visible before the other core wakes
+  uint32_t core = cm4_is_current_core() ? HSEM_COREID_CM4 : HSEM_COREID_CM7;
+  uint32_t lock = *HSEM_RLRx[queue->sem]; // 1-step lock
+  if (IS_FIELD_SET(&lock, HSEM_RLRx_LOCK) && READ_FIELD(&lock, HSEM_RLRx_COREID) == core) {
+    *HSEM_Rx[queue->sem] = TO_FIELD(core, HSEM_Rx_COREID);
+  }
+  __asm__ volatile ("sev");
+}
+
+static void ipc_dispatch(rw_reg32_t icr, ro_reg32_t misr) {
+  uint32_t pending = *misr;
+  *icr = pending; // Cleared first, so a send from a callback raises the interrupt again
+  while (pending != 0) {
+    uint32_t sem = (uint32_t)__builtin_ctz(pending);
+    pending &= pending - 1U;
+    ipc_queue_t *queue = ipc_queues[sem];
+    if (queue != NULL && queue->callback != NULL) {
+      queue->callback(queue, queue->context);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+
+bool ipc_queue_init(ipc_queue_t *queue, void *buffer, uint32_t msg_size, uint32_t capacity,
+    uint32_t sem) {
+  if (queue == NULL || buffer == NULL || msg_size == 0 || capacity < 2 ||
+      (capacity & (capacity - 1U)) != 0 || sem == CM4_BOOT_SEM || sem >= HSEM_SEM_COUNT ||
+      capacity > SRAM4_SIZE / msg_size || !ipc_in_sram4(queue, sizeof(*queue)) ||
+      !ipc_in_sram4(buffer, capacity * msg_size)) {
+    return false;
+  }
+  queue->head = 0;
+  queue->tail = 0;
+  queue->buffer = buffer;
+  queue->msg_size = msg_size;
+  queue->mask = capacity - 1U;
+  queue->sem = sem;
+  queue->callback = NULL;
+  queue->context = NULL;
+  SET_FIELD(RCC_AHB4ENR, RCC_AHB4ENR_HSEMEN);
+  return true;
+}
+
+bool ipc_send(ipc_queue_t *queue, const void *msg) {
+  uint32_t head = queue->head;
+  if (head - queue->tail > queue->mask) {
+    return false;
+  }
+  // The tail was read before the slot is overwritten, and the message is in place before the
+  // head publishes it.
+  ipc_dmb();
+  memcpy(&queue->buffer[(head & queue->mask) * queue->msg_size], msg, queue->msg_size);
+  ipc_dmb();
+  queue->head = head + 1U;
+  ipc_notify(queue);
+  return true;
+}
+
+bool ipc_receive(ipc_queue_t *queue, void *msg) {
+  uint32_t tail = queue->tail;
+  if (queue->head == tail) {
+    return false;
+  }
+  // The message is read after the head that published it, and before the tail frees its slot.
+  ipc_dmb();
+  memcpy(msg, &queue->buffer[(tail & queue->mask) * queue->msg_size], queue->msg_size);
+  ipc_dmb();
+  queue->tail = tail + 1U;
+  return true;
+}
+
+uint32_t ipc_count(const ipc_queue_t *queue) {
+  return queue->head - queue->tail;
+}
+
+void ipc_wait(const ipc_queue_t *queue) {
+  // A send between the check and the WFE leaves the event register set, so it is not missed.
+  while (queue->head == queue->tail) {
+    __asm__ volatile ("wfe");
+  }
+}
+
+bool ipc_set_callback(ipc_queue_t *queue, ipc_callback_t callback, void *context) {
+  if (ipc_queues[queue->sem] != NULL && ipc_queues[queue->sem] != queue) {
+    return false;
+  }
+  bool cm4 = cm4_is_current_core();
+  rw_reg32_t ier = cm4 ? HSEM_C2IER : HSEM_IER;
+  field32_t sem = HSEM_IER_ISEMx[queue->sem];
+  CLR_FIELD(ier, sem);
+  queue->callback = callback;
+  queue->context = context;
+  if (callback == NULL) {
+    ipc_queues[queue->sem] = NULL;
+    return true;
+  }
+  ipc_queues[queue->sem] = queue;
+  SET_FIELD(RCC_AHB4ENR, RCC_AHB4ENR_HSEMEN);
+  *(cm4 ? HSEM_C2ICR : HSEM_ICR) = sem.msk; // Drop frees from before the callback was set
+  SET_FIELD(ier, sem);
+  irq_enable(HSEMx_IRQ_NUM[cm4 ? 1 : 0]);
+  return true;
+}
+
+/**************************************************************************************************
+ * @section Interrupt Handlers
+ **************************************************************************************************/
+
+void hsem0_irq_handler(void) {
+  ipc_dispatch(HSEM_ICR, HSEM_MISR);
+}
+
+void hsem1_irq_handler(void) {
+  ipc_dispatch(HSEM_C2ICR, HSEM_C2MISR);
+}
@@ -0,0 +1,121 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/ipc.h
+ * @authors Charles Faisandier
+ * @brief Inter-core message queues.
+ *
+ * A queue is a lock-free ring of fixed size messages with one producer and one consumer, which
+ * may run on different cores. The queue and its buffer live in SRAM4 (TI_SHARED), which the
+ * CM7 maps non-cacheable, so no cache maintenance or lock is needed: the producer only writes
+ * the head, the consumer only writes the tail.
+ *
+ * Each send notifies the other core two ways, so the consumer never has to poll:
+ * - a SEV, which wakes a core sleeping in ipc_wait();
+ * - a take-and-free of the queue's HSEM semaphore, which raises the HSEM interrupt on a core
+ *   that registered a callback with ipc_set_callback().
+ *
+ * Each queue needs its own semaphore, and semaphore CM4_BOOT_SEM is reserved for booting the
+ * CM4. The HSEM handlers are shared by both cores, so they are not placed in the CM7 TCMs.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+
+typedef struct ipc_queue ipc_queue_t;
+
+/**
+ * @brief Called from the HSEM interrupt of the consumer's core when messages were sent.
+ * Notifications coalesce, so it should receive until the queue is empty.
+ */
+typedef void (*ipc_callback_t)(ipc_queue_t *queue, void *context);
+
+/** @brief Queue state. Must be placed with TI_SHARED, and set up with ipc_queue_init(). */
+struct ipc_queue {
+  volatile uint32_t head; // Messages sent, written by the producer only
+  volatile uint32_t tail; // Messages received, written by the consumer only
+  uint8_t *buffer;        // capacity * msg_size bytes, in SRAM4
+  uint32_t msg_size;
+  uint32_t mask;          // capacity - 1
+  uint32_t sem;
+  ipc_callback_t callback;
+  void *context;
+};
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+
+/**
+ * @brief Sets up an empty queue. Called once, before either core uses the queue (normally by
+ *        the CM7 before cm4_boot()).
+ * @param queue (ipc_queue_t*) Queue to set up, placed with TI_SHARED.
+ * @param buffer (void*) Message storage of capacity * msg_size bytes, placed with TI_SHARED.
+ * @param msg_size (uint32_t) Size of each message, in bytes.
+ * @param capacity (uint32_t) Number of message slots, a power of two.
+ * @param sem (uint32_t) HSEM semaphore used to notify the consumer (1-31), unique to the queue.
+ * @returns (bool) True on success, false if a parameter is invalid or the queue or buffer is
+ *          not in SRAM4.
+ */
+bool ipc_queue_init(ipc_queue_t *queue, void *buffer, uint32_t msg_size, uint32_t capacity,
+    uint32_t sem);
+
+/**
+ * @brief Sends a message and notifies the consumer. Called by the producer only. Does not block.
+ * @param queue (ipc_queue_t*) The queue.
+ * @param msg (const void*) Message of msg_size bytes.
+ * @returns (bool) True if the message was queued, false if the queue is full.
+ */
+bool ipc_send(ipc_queue_t *queue, const void *msg);
+
+/**
+ * @brief Takes the oldest message off a queue. Called by the consumer only. Does not block.
+ * @param queue (ipc_queue_t*) The queue.
+ * @param msg (void*) Receives the message, msg_size bytes.
+ * @returns (bool) True if a message was received, false if the queue is empty.
+ */
+bool ipc_receive(ipc_queue_t *queue, void *msg);
+
+/**
+ * @brief Gets the number of messages waiting in a queue.
+ * @param queue (const ipc_queue_t*) The queue.
+ * @returns (uint32_t) Messages sent and not yet received.
+ */
+uint32_t ipc_count(const ipc_queue_t *queue);
+
+/**
+ * @brief Sleeps the calling core until a queue holds a message. Called by the consumer only.
+ * @param queue (const ipc_queue_t*) The queue.
+ * @note - The core also wakes for interrupts, and for SEVs meant for other queues, and goes
+ *         back to sleep if this queue is still empty.
+ */
+void ipc_wait(const ipc_queue_t *queue);
+
+/**
+ * @brief Runs a callback on the calling core each time the queue is sent to, and enables the
+ *        HSEM interrupt of that core. Called by the consumer, on its own core.
+ * @param queue (ipc_queue_t*) The queue.
+ * @param callback (ipc_callback_t) Called from the HSEM interrupt, or NULL to stop.
+ * @param context (void*) Passed to the callback.
+ * @returns (bool) True on success, false if the queue's semaphore is used by another queue
+ *          with a callback.
+ */
+bool ipc_set_callback(ipc_queue_t *queue, ipc_callback_t callback, void *context);
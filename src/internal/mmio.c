@@ -787,12 +787,16 @@ const field32_t CEC_IER_TXACKIE   = {.msk = 0x00001000U, .pos = 12};
 
 /** @subsection HSEM Register Definitions */
 
-rw_reg32_t const HSEM_IER  = (rw_reg32_t)0x58026500U;
-ro_reg32_t const HSEM_ICR  = (ro_reg32_t)0x58026504U;
-ro_reg32_t const HSEM_ISR  = (ro_reg32_t)0x58026508U;
-ro_reg32_t const HSEM_MISR = (ro_reg32_t)0x5802650CU;
-rw_reg32_t const HSEM_CR   = (rw_reg32_t)0x58026540U;
-rw_reg32_t const HSEM_KEYR = (rw_reg32_t)0x58026544U;
+rw_reg32_t const HSEM_IER    = (rw_reg32_t)0x58026500U;
+rw_reg32_t const HSEM_ICR    = (rw_reg32_t)0x58026504U;
+ro_reg32_t const HSEM_ISR    = (ro_reg32_t)0x58026508U;
+ro_reg32_t const HSEM_MISR   = (ro_reg32_t)0x5802650CU;
+rw_reg32_t const HSEM_C2IER  = (rw_reg32_t)0x58026510U;
+rw_reg32_t const HSEM_C2ICR  = (rw_reg32_t)0x58026514U;
+ro_reg32_t const HSEM_C2ISR  = (ro_reg32_t)0x58026518U;
+ro_reg32_t const HSEM_C2MISR = (ro_reg32_t)0x5802651CU;
+rw_reg32_t const HSEM_CR     = (rw_reg32_t)0x58026540U;
+rw_reg32_t const HSEM_KEYR   = (rw_reg32_t)0x58026544U;
 
 /** @subsection Enumerated HSEM Register Definitions */
 
@@ -1543,6 +1547,44 @@ rw_reg32_t const MDMA_MDMA_C15IFCR = (rw_reg32_t)0x52000404U;
 
 /** @subsection Enumerated MDMA Register Definitions */
 
+ro_reg32_t const MDMA_MDMA_CxISR[16] = {
+  [0]  = (ro_reg32_t)0x52000040U,
+  [1]  = (ro_reg32_t)0x52000080U,
+  [2]  = (ro_reg32_t)0x520000C0U,
+  [3]  = (ro_reg32_t)0x52000100U,
+  [4]  = (ro_reg32_t)0x52000140U,
+  [5]  = (ro_reg32_t)0x52000180U,
+  [6]  = (ro_reg32_t)0x520001C0U,
+  [7]  = (ro_reg32_t)0x52000200U,
+  [8]  = (ro_reg32_t)0x52000240U,
+  [9]  = (ro_reg32_t)0x52000280U,
+  [10] = (ro_reg32_t)0x520002C0U,
+  [11] = (ro_reg32_t)0x52000300U,
+  [12] = (ro_reg32_t)0x52000340U,
+  [13] = (ro_reg32_t)0x52000380U,
+  [14] = (ro_reg32_t)0x520003C0U,
+  [15] = (ro_reg32_t)0x52000400U,
+};
+
+rw_reg32_t const MDMA_MDMA_CxIFCR[16] = {
+  [0]  = (rw_reg32_t)0x52000044U,
+  [1]  = (rw_reg32_t)0x52000084U,
+  [2]  = (rw_reg32_t)0x520000C4U,
+  [3]  = (rw_reg32_t)0x52000104U,
+  [4]  = (rw_reg32_t)0x52000144U,
+  [5]  = (rw_reg32_t)0x52000184U,
+  [6]  = (rw_reg32_t)0x520001C4U,
+  [7]  = (rw_reg32_t)0x52000204U,
+  [8]  = (rw_reg32_t)0x52000244U,
+  [9]  = (rw_reg32_t)0x52000284U,
+  [10] = (rw_reg32_t)0x520002C4U,
+  [11] = (rw_reg32_t)0x52000304U,
+  [12] = (rw_reg32_t)0x52000344U,
+  [13] = (rw_reg32_t)0x52000384U,
+  [14] = (rw_reg32_t)0x520003C4U,
+  [15] = (rw_reg32_t)0x52000404U,
+};
+
 ro_reg32_t const MDMA_MDMA_CxESR[16] = {
   [0]  = (ro_reg32_t)0x52000048U,
   [1]  = (ro_reg32_t)0x52000088U,
@@ -4133,6 +4175,9 @@ const field32_t RCC_APB4RSTR_COMP12RST             = {.msk = 0x00004000U, .pos =
 const field32_t RCC_APB4RSTR_VREFRST               = {.msk = 0x00008000U, .pos = 15};
 const field32_t RCC_APB4RSTR_SAI4RST               = {.msk = 0x00200000U, .pos = 21};
 const field32_t RCC_GCR_WW1RSC                     = {.msk = 0x00000001U, .pos = 0};
+const field32_t RCC_GCR_WW2RSC                     = {.msk = 0x00000002U, .pos = 1};
+const field32_t RCC_GCR_BOOT_C1                    = {.msk = 0x00000004U, .pos = 2};
+const field32_t RCC_GCR_BOOT_C2                    = {.msk = 0x00000008U, .pos = 3};
 const field32_t RCC_D3AMR_BDMAAMEN                 = {.msk = 0x00000001U, .pos = 0};
 const field32_t RCC_D3AMR_LPUART1AMEN              = {.msk = 0x00000008U, .pos = 3};
 const field32_t RCC_D3AMR_SPI6AMEN                 = {.msk = 0x00000020U, .pos = 5};
@@ -4944,6 +4989,7 @@ rw_reg32_t const SYSCFG_EXTICR4 = (rw_reg32_t)0x58000414U;
 rw_reg32_t const SYSCFG_CCCSR   = (rw_reg32_t)0x58000420U;
 ro_reg32_t const SYSCFG_CCVR    = (ro_reg32_t)0x58000424U;
 rw_reg32_t const SYSCFG_CCCR    = (rw_reg32_t)0x58000428U;
+rw_reg32_t const SYSCFG_PWRCR   = (rw_reg32_t)0x5800042CU;
 ro_reg32_t const SYSCFG_PKGR    = (ro_reg32_t)0x58000524U;
 ro_reg32_t const SYSCFG_UR0     = (ro_reg32_t)0x58000700U;
 rw_reg32_t const SYSCFG_UR2     = (rw_reg32_t)0x58000708U;
@@ -4975,6 +5021,7 @@ const field32_t SYSCFG_CCVR_NCV       = {.msk = 0x0000000FU, .pos = 0};
 const field32_t SYSCFG_CCVR_PCV       = {.msk = 0x000000F0U, .pos = 4};
 const field32_t SYSCFG_CCCR_NCC       = {.msk = 0x0000000FU, .pos = 0};
 const field32_t SYSCFG_CCCR_PCC       = {.msk = 0x000000F0U, .pos = 4};
+const field32_t SYSCFG_PWRCR_ODEN     = {.msk = 0x00000001U, .pos = 0};
 const field32_t SYSCFG_PKGR_PKG       = {.msk = 0x0000000FU, .pos = 0};
 const field32_t SYSCFG_UR0_BKS        = {.msk = 0x00000001U, .pos = 0};
 const field32_t SYSCFG_UR0_RDP        = {.msk = 0x00FF0000U, .pos = 16};
@@ -8280,6 +8327,7 @@ rw_reg32_t const DMAx_S7CR[3] = {
 
 const field32_t DMAx_S0CR_MBURST = {.msk = 0x01800000U, .pos = 23};
 const field32_t DMAx_S0CR_PBURST = {.msk = 0x00600000U, .pos = 21};
+const field32_t DMAx_S0CR_TRBUFF = {.msk = 0x00100000U, .pos = 20};
 const field32_t DMAx_S0CR_CT     = {.msk = 0x00080000U, .pos = 19};
 const field32_t DMAx_S0CR_DBM    = {.msk = 0x00040000U, .pos = 18};
 const field32_t DMAx_S0CR_PL     = {.msk = 0x00030000U, .pos = 16};
@@ -13927,39 +13975,44 @@ rw_reg32_t const NVIC_STIR = (rw_reg32_t)0xE000EF00U;
 
 /** @subsection Enumerated NVIC Register Definitions */
 
-rw_reg32_t const NVIC_ISERx[4] = {
+rw_reg32_t const NVIC_ISERx[5] = {
   [0] = (rw_reg32_t)0xE000E100U,
   [1] = (rw_reg32_t)0xE000E104U,
   [2] = (rw_reg32_t)0xE000E108U,
   [3] = (rw_reg32_t)0xE000E10CU,
+  [4] = (rw_reg32_t)0xE000E110U,
 };
 
-rw_reg32_t const NVIC_ICERx[4] = {
+rw_reg32_t const NVIC_ICERx[5] = {
   [0] = (rw_reg32_t)0xE000E180U,
   [1] = (rw_reg32_t)0xE000E184U,
   [2] = (rw_reg32_t)0xE000E188U,
   [3] = (rw_reg32_t)0xE000E18CU,
+  [4] = (rw_reg32_t)0xE000E190U,
 };
 
-rw_reg32_t const NVIC_ISPRx[4] = {
+rw_reg32_t const NVIC_ISPRx[5] = {
   [0] = (rw_reg32_t)0xE000E200U,
   [1] = (rw_reg32_t)0xE000E204U,
   [2] = (rw_reg32_t)0xE000E208U,
   [3] = (rw_reg32_t)0xE000E20CU,
+  [4] = (rw_reg32_t)0xE000E210U,
 };
 
-rw_reg32_t const NVIC_ICPRx[4] = {
+rw_reg32_t const NVIC_ICPRx[5] = {
   [0] = (rw_reg32_t)0xE000E280U,
   [1] = (rw_reg32_t)0xE000E284U,
   [2] = (rw_reg32_t)0xE000E288U,
-  [3] = (rw_reg32_t)0xE000E2C0U,
+  [3] = (rw_reg32_t)0xE000E28CU,
+  [4] = (rw_reg32_t)0xE000E290U,
 };
 
-ro_reg32_t const NVIC_IABRx[4] = {
+ro_reg32_t const NVIC_IABRx[5] = {
   [0] = (ro_reg32_t)0xE000E300U,
   [1] = (ro_reg32_t)0xE000E304U,
   [2] = (ro_reg32_t)0xE000E308U,
   [3] = (ro_reg32_t)0xE000E30CU,
+  [4] = (ro_reg32_t)0xE000E310U,
 };
 
 rw_reg32_t const NVIC_IPRx[39] = {
@@ -14024,7 +14077,7 @@ field32_t const NVIC_IPRx_IPR_Nx[4] = {
 /** @subsection MPU Register Definitions */
 
 ro_reg32_t const MPU_MPU_TYPER = (ro_reg32_t)0xE000ED90U;
-ro_reg32_t const MPU_MPU_CTRL  = (ro_reg32_t)0xE000ED94U;
+rw_reg32_t const MPU_MPU_CTRL  = (rw_reg32_t)0xE000ED94U;
 rw_reg32_t const MPU_MPU_RNR   = (rw_reg32_t)0xE000ED98U;
 rw_reg32_t const MPU_MPU_RBAR  = (rw_reg32_t)0xE000ED9CU;
 rw_reg32_t const MPU_MPU_RASR  = (rw_reg32_t)0xE000EDA0U;
@@ -14225,6 +14278,30 @@ field32_t const SCB_SHPR3_PRI_1x[6] = {
   [5] = {.msk = 0xFF000000U, .pos = 24},
 };
 
+/** @subsection SCB Cache Register Definitions */
+
+ro_reg32_t const SCB_CLIDR    = (ro_reg32_t)0xE000ED78U;
+ro_reg32_t const SCB_CTR      = (ro_reg32_t)0xE000ED7CU;
+ro_reg32_t const SCB_CCSIDR   = (ro_reg32_t)0xE000ED80U;
+rw_reg32_t const SCB_CSSELR   = (rw_reg32_t)0xE000ED84U;
+rw_reg32_t const SCB_ICIALLU  = (rw_reg32_t)0xE000EF50U;
+rw_reg32_t const SCB_ICIMVAU  = (rw_reg32_t)0xE000EF58U;
+rw_reg32_t const SCB_DCIMVAC  = (rw_reg32_t)0xE000EF5CU;
+rw_reg32_t const SCB_DCISW    = (rw_reg32_t)0xE000EF60U;
+rw_reg32_t const SCB_DCCMVAU  = (rw_reg32_t)0xE000EF64U;
+rw_reg32_t const SCB_DCCMVAC  = (rw_reg32_t)0xE000EF68U;
+rw_reg32_t const SCB_DCCSW    = (rw_reg32_t)0xE000EF6CU;
+rw_reg32_t const SCB_DCCIMVAC = (rw_reg32_t)0xE000EF70U;
+rw_reg32_t const SCB_DCCISW   = (rw_reg32_t)0xE000EF74U;
+
+/** @subsection SCB Cache Register Field Definitions */
+
+const field32_t SCB_CCSIDR_LINESIZE      = {.msk = 0x00000007U, .pos = 0};
+const field32_t SCB_CCSIDR_ASSOCIATIVITY = {.msk = 0x00001FF8U, .pos = 3};
+const field32_t SCB_CCSIDR_NUMSETS       = {.msk = 0x0FFFE000U, .pos = 13};
+const field32_t SCB_CSSELR_IND           = {.msk = 0x00000001U, .pos = 0};
+const field32_t SCB_CSSELR_LEVEL         = {.msk = 0x0000000EU, .pos = 1};
+
 /**************************************************************************************************
  * @section Debug Definitions
  **************************************************************************************************/
@@ -14267,6 +14344,21 @@ const field32_t DBG_DEMCR_MON_STEP     = {.msk = 0x00040000U, .pos = 18};
 const field32_t DBG_DEMCR_MON_REQ      = {.msk = 0x00080000U, .pos = 19};
 const field32_t DBG_DEMCR_TRCENA       = {.msk = 0x01000000U, .pos = 24};
 
+/**************************************************************************************************
+ * @section DWT Definitions
+ **************************************************************************************************/
+
+/** @subsection DWT Register Definitions */
+
+rw_reg32_t const DWT_CTRL   = (rw_reg32_t)0xE0001000U;
+rw_reg32_t const DWT_CYCCNT = (rw_reg32_t)0xE0001004U;
+rw_reg32_t const DWT_LAR    = (rw_reg32_t)0xE0001FB0U;
+
+/** @subsection DWT Register Field Definitions */
+
+const field32_t DWT_CTRL_CYCCNTENA = {.msk = 0x00000001U, .pos = 0};
+const field32_t DWT_CTRL_NOCYCCNT  = {.msk = 0x02000000U, .pos = 25};
+
 /**************************************************************************************************
  * @section PF Definitions
  **************************************************************************************************/
@@ -42,27 +42,6 @@ typedef struct { uint32_t msk; int32_t pos; } field32_t; /** @brief 32 bit regis
 typedef struct { uint16_t msk; int32_t pos; } field16_t; /** @brief 16 bit register field type. */
 typedef struct { uint8_t  msk; int32_t pos; } field8_t;  /** @brief 8 bit register field type. */
 
-typedef struct {
-    volatile uint32_t *CR1;
-    volatile uint32_t *CR2;
-    volatile uint32_t *CR3;
-    volatile uint32_t *BRR;
-    volatile uint32_t *TDR;
-    volatile uint32_t *RDR;
-    
-} UART_Regs;
-
-static UART_Regs UART_MAP[9] = {
-    [4] = { (uint32_t*)0x40004C00U, (uint32_t*)0x40004C04U, (uint32_t*)0x40004C08U, 
-            (uint32_t*)0x40004C0CU, (uint32_t*)0x40004C28U, (uint32_t*)0x40004C24U },
-    [5] = { (uint32_t*)0x40005000U, (uint32_t*)0x40005004U, (uint32_t*)0x40005008U, 
-            (uint32_t*)0x4000500CU, (uint32_t*)0x40005028U, (uint32_t*)0x40005024U },
-    [7] = { (uint32_t*)0x40007800U, (uint32_t*)0x40007804U, (uint32_t*)0x40007808U, 
-            (uint32_t*)0x4000780CU, (uint32_t*)0x40007828U, (uint32_t*)0x40007824U },
-    [8] = { (uint32_t*)0x40007C00U, (uint32_t*)0x40007C04U, (uint32_t*)0x40007C08U, 
-            (uint32_t*)0x40007C0CU, (uint32_t*)0x40007C28U, (uint32_t*)0x40007C24U },
-};
-
 /**************************************************************************************************
  * @section MMIO Utilities
  **************************************************************************************************/
@@ -704,12 +683,16 @@ extern const field32_t CEC_IER_TXACKIE;   /** @brief Tx-Missing acknowledge erro
 
 /** @subsection HSEM Register Definitions */
 
-extern rw_reg32_t const HSEM_IER;  /** @brief HSEM interrupt enable register. */
-extern ro_reg32_t const HSEM_ICR;  /** @brief HSEM interrupt clear register. */
-extern ro_reg32_t const HSEM_ISR;  /** @brief HSEM interrupt status register. */
-extern ro_reg32_t const HSEM_MISR; /** @brief HSEM masked interrupt status register. */
-extern rw_reg32_t const HSEM_CR;   /** @brief HSEM clear register. */
-extern rw_reg32_t const HSEM_KEYR; /** @brief HSEM interrupt clear register. */
+extern rw_reg32_t const HSEM_IER;    /** @brief HSEM interrupt enable register. */
+extern rw_reg32_t const HSEM_ICR;    /** @brief HSEM interrupt clear register. */
+extern ro_reg32_t const HSEM_ISR;    /** @brief HSEM interrupt status register. */
+extern ro_reg32_t const HSEM_MISR;   /** @brief HSEM masked interrupt status register. */
+extern rw_reg32_t const HSEM_C2IER;  /** @brief HSEM interrupt enable register (CM4 core). */
+extern rw_reg32_t const HSEM_C2ICR;  /** @brief HSEM interrupt clear register (CM4 core). */
+extern ro_reg32_t const HSEM_C2ISR;  /** @brief HSEM interrupt status register (CM4 core). */
+extern ro_reg32_t const HSEM_C2MISR; /** @brief HSEM masked interrupt status register (CM4 core). */
+extern rw_reg32_t const HSEM_CR;     /** @brief HSEM clear register. */
+extern rw_reg32_t const HSEM_KEYR;   /** @brief HSEM interrupt clear register. */
 
 /** @subsection Enumerated HSEM Register Definitions */
 
@@ -969,6 +952,8 @@ extern rw_reg32_t const MDMA_MDMA_C15IFCR; /** @brief MDMA channel x interrupt f
 
 /** @subsection Enumerated MDMA Register Definitions */
 
+extern ro_reg32_t const MDMA_MDMA_CxISR[16];   /** @brief MDMA channel x interrupt/status register. */
+extern rw_reg32_t const MDMA_MDMA_CxIFCR[16];  /** @brief MDMA channel x interrupt flag clear register. */
 extern ro_reg32_t const MDMA_MDMA_CxESR[16];   /** @brief MDMA channel x error status register. */
 extern rw_reg32_t const MDMA_MDMA_CxCR[16];    /** @brief This register is used to control the concerned channel. */
 extern rw_reg32_t const MDMA_MDMA_CxTCR[16];   /** @brief This register is used to configure the concerned channel. */
@@ -2569,6 +2554,9 @@ extern const field32_t RCC_APB4RSTR_COMP12RST;             /** @brief COMP12 blo
 extern const field32_t RCC_APB4RSTR_VREFRST;               /** @brief VREF block reset. */
 extern const field32_t RCC_APB4RSTR_SAI4RST;               /** @brief SAI4 block reset. */
 extern const field32_t RCC_GCR_WW1RSC;                     /** @brief WWDG1 reset scope control. */
+extern const field32_t RCC_GCR_WW2RSC;                     /** @brief WWDG2 reset scope control. */
+extern const field32_t RCC_GCR_BOOT_C1;                    /** @brief Force allow CM7 to boot. */
+extern const field32_t RCC_GCR_BOOT_C2;                    /** @brief Force allow CM4 to boot. */
 extern const field32_t RCC_D3AMR_BDMAAMEN;                 /** @brief BDMA and DMAMUX autonomous mode enable. */
 extern const field32_t RCC_D3AMR_LPUART1AMEN;              /** @brief LPUART1 autonomous mode enable. */
 extern const field32_t RCC_D3AMR_SPI6AMEN;                 /** @brief SPI6 autonomous mode enable. */
@@ -3062,6 +3050,7 @@ extern rw_reg32_t const SYSCFG_EXTICR4; /** @brief External interrupt configurat
 extern rw_reg32_t const SYSCFG_CCCSR;   /** @brief Compensation cell control/status register. */
 extern ro_reg32_t const SYSCFG_CCVR;    /** @brief SYSCFG compensation cell value register. */
 extern rw_reg32_t const SYSCFG_CCCR;    /** @brief SYSCFG compensation cell code register. */
+extern rw_reg32_t const SYSCFG_PWRCR;   /** @brief SYSCFG power control register. */
 extern ro_reg32_t const SYSCFG_PKGR;    /** @brief SYSCFG package register. */
 extern ro_reg32_t const SYSCFG_UR0;     /** @brief SYSCFG user register 0. */
 extern rw_reg32_t const SYSCFG_UR2;     /** @brief SYSCFG user register 2. */
@@ -3093,6 +3082,7 @@ extern const field32_t SYSCFG_CCVR_NCV;       /** @brief NMOS compensation value
 extern const field32_t SYSCFG_CCVR_PCV;       /** @brief PMOS compensation value. */
 extern const field32_t SYSCFG_CCCR_NCC;       /** @brief NMOS compensation code. */
 extern const field32_t SYSCFG_CCCR_PCC;       /** @brief PMOS compensation code. */
+extern const field32_t SYSCFG_PWRCR_ODEN;     /** @brief Overdrive enable (VOS0). */
 extern const field32_t SYSCFG_PKGR_PKG;       /** @brief Package. */
 extern const field32_t SYSCFG_UR0_BKS;        /** @brief Bank swap. */
 extern const field32_t SYSCFG_UR0_RDP;        /** @brief Readout protection. */
@@ -5088,6 +5078,7 @@ extern rw_reg32_t const DMAx_S7CR[3];      /** @brief Stream x configuration reg
 
 extern const field32_t DMAx_S0CR_MBURST; /** @brief Memory burst transfer configuration. */
 extern const field32_t DMAx_S0CR_PBURST; /** @brief Peripheral burst transfer configuration. */
+extern const field32_t DMAx_S0CR_TRBUFF; /** @brief Enable the DMA to handle bufferable transfers. Must be set for U(S)ART requests. */
 extern const field32_t DMAx_S0CR_CT;     /** @brief Current target (only in double buffer mode). */
 extern const field32_t DMAx_S0CR_DBM;    /** @brief Double buffer mode. */
 extern const field32_t DMAx_S0CR_PL;     /** @brief Priority level. */
@@ -7942,11 +7933,11 @@ extern rw_reg32_t const NVIC_STIR; /** @brief Software trigger interrupt registe
 
 /** @subsection Enumerated NVIC Register Definitions */
 
-extern rw_reg32_t const NVIC_ISERx[4]; /** @brief Interrupt set-enable register. */
-extern rw_reg32_t const NVIC_ICERx[4]; /** @brief Interrupt clear-enable register. */
-extern rw_reg32_t const NVIC_ISPRx[4]; /** @brief Interrupt set-pending register. */
-extern rw_reg32_t const NVIC_ICPRx[4]; /** @brief Interrupt clear-pending register. */
-extern ro_reg32_t const NVIC_IABRx[4]; /** @brief Interrupt active bit register. */
+extern rw_reg32_t const NVIC_ISERx[5]; /** @brief Interrupt set-enable register. */
+extern rw_reg32_t const NVIC_ICERx[5]; /** @brief Interrupt clear-enable register. */
+extern rw_reg32_t const NVIC_ISPRx[5]; /** @brief Interrupt set-pending register. */
+extern rw_reg32_t const NVIC_ICPRx[5]; /** @brief Interrupt clear-pending register. */
+extern ro_reg32_t const NVIC_IABRx[5]; /** @brief Interrupt active bit register. */
 extern rw_reg32_t const NVIC_IPRx[39]; /** @brief Interrupt priority register. */
 
 /** @subsection NVIC_STIR Register Field Definitions */
@@ -7964,7 +7955,7 @@ extern const field32_t NVIC_IPRx_IPR_Nx[4]; /** @brief IPR_N0. */
 /** @subsection MPU Register Definitions */
 
 extern ro_reg32_t const MPU_MPU_TYPER; /** @brief MPU type register. */
-extern ro_reg32_t const MPU_MPU_CTRL;  /** @brief MPU control register. */
+extern rw_reg32_t const MPU_MPU_CTRL;  /** @brief MPU control register. */
 extern rw_reg32_t const MPU_MPU_RNR;   /** @brief MPU region number register. */
 extern rw_reg32_t const MPU_MPU_RBAR;  /** @brief MPU region base address register. */
 extern rw_reg32_t const MPU_MPU_RASR;  /** @brief MPU region attribute and size register. */
@@ -8157,6 +8148,30 @@ extern const field32_t SCB_ACTRL_ACTRL_DISITMATBFLUSH; /** @brief DISITMATBFLUSH
 extern const field32_t SCB_SHPR1_PRI_x[7];  /** @brief Priority of system handler 4. */
 extern const field32_t SCB_SHPR3_PRI_1x[6]; /** @brief Priority of system handler 14. */
 
+/** @subsection SCB Cache Register Definitions */
+
+extern ro_reg32_t const SCB_CLIDR;    /** @brief Cache level ID register. */
+extern ro_reg32_t const SCB_CTR;      /** @brief Cache type register. */
+extern ro_reg32_t const SCB_CCSIDR;   /** @brief Cache size ID register. */
+extern rw_reg32_t const SCB_CSSELR;   /** @brief Cache size selection register. */
+extern rw_reg32_t const SCB_ICIALLU;  /** @brief Instruction cache invalidate all to PoU. */
+extern rw_reg32_t const SCB_ICIMVAU;  /** @brief Instruction cache invalidate by address to PoU. */
+extern rw_reg32_t const SCB_DCIMVAC;  /** @brief Data cache invalidate by address to PoC. */
+extern rw_reg32_t const SCB_DCISW;    /** @brief Data cache invalidate by set/way. */
+extern rw_reg32_t const SCB_DCCMVAU;  /** @brief Data cache clean by address to PoU. */
+extern rw_reg32_t const SCB_DCCMVAC;  /** @brief Data cache clean by address to PoC. */
+extern rw_reg32_t const SCB_DCCSW;    /** @brief Data cache clean by set/way. */
+extern rw_reg32_t const SCB_DCCIMVAC; /** @brief Data cache clean and invalidate by address to PoC. */
+extern rw_reg32_t const SCB_DCCISW;   /** @brief Data cache clean and invalidate by set/way. */
+
+/** @subsection SCB Cache Register Field Definitions */
+
+extern const field32_t SCB_CCSIDR_LINESIZE;      /** @brief log2(words per line) - 2. */
+extern const field32_t SCB_CCSIDR_ASSOCIATIVITY; /** @brief Number of ways - 1. */
+extern const field32_t SCB_CCSIDR_NUMSETS;       /** @brief Number of sets - 1. */
+extern const field32_t SCB_CSSELR_IND;           /** @brief Instruction (1) or data (0) cache. */
+extern const field32_t SCB_CSSELR_LEVEL;         /** @brief Cache level - 1. */
+
 /**************************************************************************************************
  * @section Debug Definitions
  **************************************************************************************************/
@@ -8199,6 +8214,21 @@ extern const field32_t DBG_DEMCR_MON_STEP;     /** @brief Monitor step. */
 extern const field32_t DBG_DEMCR_MON_REQ;      /** @brief Monitor request. */
 extern const field32_t DBG_DEMCR_TRCENA;       /** @brief Trace enable. */
 
+/**************************************************************************************************
+ * @section DWT Definitions
+ **************************************************************************************************/
+
+/** @subsection DWT Register Definitions */
+
+extern rw_reg32_t const DWT_CTRL;   /** @brief Control register. */
+extern rw_reg32_t const DWT_CYCCNT; /** @brief Cycle count register. */
+extern rw_reg32_t const DWT_LAR;    /** @brief Lock access register. */
+
+/** @subsection DWT Register Field Definitions */
+
+extern const field32_t DWT_CTRL_CYCCNTENA; /** @brief Enable the cycle counter. */
+extern const field32_t DWT_CTRL_NOCYCCNT;  /** @brief Cycle counter not implemented. */
+
 /**************************************************************************************************
  * @section PF Definitions
  **************************************************************************************************/
@@ -0,0 +1,70 @@
+/**
+ * This file is part of the Titan Project.
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/internal/sections.h
+ * @authors Charles Faisandier
+ * @brief Attributes for placing code and data in the CM7 tightly coupled memories, the DMA
+ *        buffer region and the memory shared with the CM4.
+ *
+ * ITCM and DTCM are accessed with no wait states and are not affected by cache misses, so
+ * they are meant for interrupt handlers, the DMA dispatch path and the control loop. The
+ * sections are set up by linker.ld and loaded/cleared by the CM7 reset handler.
+ *
+ * Neither TCM is reachable by the DMA1/DMA2 controllers, so buffers handed to a DMA stream
+ * must not be placed with TI_FAST_DATA or TI_FAST_BSS. The TCMs are private to the CM7, so
+ * code that runs on the CM4 must not use anything placed there either.
+ */
+
+#pragma once
+#include "cache.h"
+
+/**************************************************************************************************
+ * @section Placement Attributes
+ **************************************************************************************************/
+
+/**
+ * @brief Places a function in ITCM (copied from flash at boot).
+ * Callees that are not inlined stay in flash, and are reached through linker veneers.
+ */
+#define TI_FAST_CODE __attribute__((section(".itcm_text")))
+
+/** @brief Places an initialized variable in DTCM (copied from flash at boot). */
+#define TI_FAST_DATA __attribute__((section(".dtcm_data")))
+
+/** @brief Places a zero-initialized variable in DTCM (cleared at boot). */
+#define TI_FAST_BSS __attribute__((section(".dtcm_bss")))
+
+/**
+ * @brief Places a zero-initialized variable in the non-cacheable DMA buffer region (SRAM1/2,
+ * cleared at boot). Buffers placed here need no cache maintenance (see cache.h).
+ */
+#define TI_DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(CACHE_LINE_SIZE)))
+
+/**
+ * @brief Places a zero-initialized variable in SRAM4, which both cores reach and the CM7 maps
+ * non-cacheable (cleared by the CM7 at boot, before the CM4 is released). For data the cores
+ * exchange.
+ */
+#define TI_SHARED __attribute__((section(".shared_bss")))
+
+/**
+ * @brief Places an initialized variable owned by the CM4 in SRAM4 (copied from flash by the
+ * CM4 at boot, so it is reset along with the CM4).
+ */
+#define TI_CM4_DATA __attribute__((section(".cm4_data")))
+
+/** @brief Places a zero-initialized variable owned by the CM4 in SRAM4 (cleared by the CM4). */
+#define TI_CM4_BSS __attribute__((section(".cm4_bss")))
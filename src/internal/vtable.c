@@ -19,12 +19,24 @@
  * @brief Contains armv7m vector table definitions.
  */
 
+#include "cm4.h"
 #include "interrupt.h"
+#include "mmio.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /** @brief Size of the interrupt vector table. */
 #define VTABLE_SIZE 256
 
+/**
+ * @brief Size of the RAM copy of the vector table, including the initial stack pointer.
+ * Covers all 166 CM7 vectors. VTOR requires the table to be aligned to its size rounded up
+ * to a power of two.
+ */
+#define RAM_VTABLE_SIZE 256
+#define RAM_VTABLE_ALIGN (RAM_VTABLE_SIZE * 4)
+
 /** @brief Interrupt vector table (CM7 core). */
 __attribute__((
     used,
@@ -204,3 +216,74 @@ __attribute__((
     [158] = (uint32_t)&wwdg1_rst_irq_handler,
     [163] = (uint32_t)&cpu2_hold_core_irq_handler,
 };
+
+/** @brief RAM copy of the CM7 vector table (see irq_relocate_vtable()). */
+__attribute__((
+    section(".cm7_ram_vtable"),
+    aligned(RAM_VTABLE_ALIGN))) static volatile uint32_t cm7_ram_vtable[RAM_VTABLE_SIZE];
+
+/** @brief RAM copy of the CM4 vector table, in SRAM4 since the CM4 cannot reach DTCM. */
+__attribute__((
+    section(".cm4_ram_vtable"),
+    aligned(RAM_VTABLE_ALIGN))) static volatile uint32_t cm4_ram_vtable[RAM_VTABLE_SIZE];
+
+/** @brief Start of the flash vector tables (initial stack pointer followed by the table). */
+extern const uint32_t __cm7_vtable_start[];
+extern const uint32_t __cm4_vtable_start[];
+
+/** @brief RAM vector table of the calling core. */
+static volatile uint32_t *vtable_ram(void) {
+  return cm4_is_current_core() ? cm4_ram_vtable : cm7_ram_vtable;
+}
+
+/**
+ * @brief Link time entry of the calling core's vector table. The CM4 table only lists the
+ * vectors that differ between the cores, and takes the shared peripheral handlers from the CM7
+ * table.
+ */
+static uint32_t vtable_flash_entry(int32_t index) {
+  if (cm4_is_current_core() && __cm4_vtable_start[index] != 0U) {
+    return __cm4_vtable_start[index];
+  }
+  return __cm7_vtable_start[index];
+}
+
+static bool vtable_relocated(void) {
+  return *SCB_VTOR == (uint32_t)vtable_ram();
+}
+
+void irq_relocate_vtable(void) {
+  uint32_t primask = irq_save();
+  if (!vtable_relocated()) {
+    volatile uint32_t *table = vtable_ram();
+    for (int32_t i = 0; i < RAM_VTABLE_SIZE; i++) {
+      table[i] = vtable_flash_entry(i);
+    }
+    // The table has to be in place before the core fetches vectors from it.
+    __asm__ volatile ("dsb" ::: "memory");
+    *SCB_VTOR = (uint32_t)table;
+    __asm__ volatile ("dsb\n\tisb" ::: "memory");
+  }
+  irq_restore(primask);
+}
+
+bool irq_attach(int32_t irq, irq_handler_t handler) {
+  if (irq < 0 || irq >= IRQ_COUNT || handler == NULL) {
+    return false;
+  }
+  irq_relocate_vtable();
+  vtable_ram()[irq + IRQ_EXC_OFFSET] = (uint32_t)handler;
+  __asm__ volatile ("dsb" ::: "memory");
+  return true;
+}
+
+bool irq_detach(int32_t irq) {
+  if (irq < 0 || irq >= IRQ_COUNT) {
+    return false;
+  }
+  if (vtable_relocated()) {
+    vtable_ram()[irq + IRQ_EXC_OFFSET] = vtable_flash_entry(irq + IRQ_EXC_OFFSET);
+    __asm__ volatile ("dsb" ::: "memory");
+  }
+  return true;
+}
@@ -5,9 +5,15 @@
 #include "peripheral/uart.h"
 #include "peripheral/pwm.h"
 #include "peripheral/spi.h"
+#include "internal/clock.h"
+#include "internal/cm4.h"
+#include "internal/ipc.h"
+#include "internal/sections.h"
 #include "internal/mmio.h"
 #include "internal/led.h"
 #include "peripheral/systick.h"
+#include "peripheral/timebase.h"
+#include "util/swtimer.h"
 
 #define USR_BUTTON 9
 #define GREEN_LED 49
@@ -44,7 +50,7 @@ extern uint32_t __heap_start;
 //         .mutex_timeout = 0
 //     };
 
-//     spi_init(instance, &config);
+//     spi_init(instance, &config, NULL, NULL);
 
 //     asm("BKPT #0");
 
@@ -91,7 +97,8 @@ void test_uart(){
     config.parity = parity;
     config.data_length = data_length;
     config.baud_rate = 9600;
-    config.clk_freq = 4000000; // 60 MHz
+    config.clk_source = UART_CLOCK_PCLK;
+    config.clk_freq = 0; // Read from the RCC
 
     // UART 1-3, 6 is fine (maybe)
     // UART 4-5, probably 7/8 isn't working (maybe)
@@ -148,9 +155,6 @@ void test_pwm() {
         //         .clock_freq = 2000000,
         //         .duty = 500,
         //     };
-    WRITE_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[1], 0b111);
-    WRITE_FIELD(RCC_D2CFGR, RCC_D2CFGR_D2PPREx[2], 0b111);
-    WRITE_FIELD(RCC_D1CFGR, RCC_D1CFGR_HPRE, 0b1001);
     // enum ti_errc_t my_err;
     // enum ti_errc_t* errc = &my_err;
     asm("BKPT #0");
@@ -202,7 +206,7 @@ void test_pwm() {
         .channel = 1,
         .freq = 40,
         .duty = 500,
-        .clock_freq = 2000000,
+        .clock_freq = 0, // Read from the RCC
     };
 
     enum ti_errc_t err;
@@ -216,6 +220,101 @@ void test_pwm() {
     }
 }
 
+// Bumped by the CM4, read by the CM7
+static TI_SHARED volatile uint32_t cm4_heartbeat;
+
+static void cm4_blink_task(void *context) {
+    (void)context;
+    led_init(YELLOW);
+    while (true) {
+        toggle_led(YELLOW);
+        cm4_heartbeat++;
+        delay(10000000);
+    }
+}
+
+void test_cm4() {
+    if (!cm4_boot(cm4_blink_task, NULL)) {
+        asm("BKPT #0");
+    }
+    while (!cm4_running()) {}
+    uint32_t last = cm4_heartbeat;
+    while (cm4_heartbeat == last) {}
+    asm("BKPT #0"); // CM4 is up and blinking the yellow LED
+}
+
+// Commands from the CM7 to the CM4, and the CM4's replies
+#define IPC_TEST_DEPTH 8
+static TI_SHARED ipc_queue_t ipc_cmd_queue;
+static TI_SHARED ipc_queue_t ipc_reply_queue;
+static TI_SHARED uint32_t ipc_cmd_buffer[IPC_TEST_DEPTH];
+static TI_SHARED uint32_t ipc_reply_buffer[IPC_TEST_DEPTH];
+
+static void cm4_echo_task(void *context) {
+    (void)context;
+    uint32_t msg;
+    while (true) {
+        ipc_wait(&ipc_cmd_queue);
+        while (ipc_receive(&ipc_cmd_queue, &msg)) {
+            msg++;
+            while (!ipc_send(&ipc_reply_queue, &msg)) {}
+        }
+    }
+}
+
+void test_ipc() {
+    if (!ipc_queue_init(&ipc_cmd_queue, ipc_cmd_buffer, sizeof(uint32_t), IPC_TEST_DEPTH, 1) ||
+        !ipc_queue_init(&ipc_reply_queue, ipc_reply_buffer, sizeof(uint32_t), IPC_TEST_DEPTH, 2) ||
+        !cm4_boot(cm4_echo_task, NULL)) {
+        asm("BKPT #0");
+    }
+    while (!cm4_running()) {}
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t msg = i;
+        uint64_t start = time_now_cycles();
+        ipc_send(&ipc_cmd_queue, &msg);
+        ipc_wait(&ipc_reply_queue);
+        ipc_receive(&ipc_reply_queue, &msg);
+        volatile uint64_t round_trip = time_now_cycles() - start; // CM7 cycles, for the debugger
+        (void)round_trip;
+        if (msg != i + 1) {
+            asm("BKPT #0");
+        }
+    }
+    asm("BKPT #0"); // All echoes received
+}
+
+// Blinks each LED at its own rate, all at once, then stops them from a one-shot timer
+static swtimer_t led_timers[3];
+static swtimer_t led_stop_timer;
+
+static void led_timer_callback(swtimer_t *timer, void *context) {
+    (void)timer;
+    toggle_led((int)(uintptr_t)context);
+}
+
+static void led_stop_callback(swtimer_t *timer, void *context) {
+    (void)timer;
+    (void)context;
+    for (int i = 0; i < 3; i++) {
+        swtimer_stop(&led_timers[i]);
+    }
+}
+
+void test_swtimer() {
+    const uint32_t periods[3] = {250, 500, 1000};
+    for (int led = GREEN; led <= RED; led++) {
+        led_init(led);
+        swtimer_start(&led_timers[led], periods[led], periods[led], led_timer_callback,
+                      (void *)(uintptr_t)led);
+    }
+    swtimer_start(&led_stop_timer, 10000, 0, led_stop_callback, NULL);
+    while (swtimer_active(&led_stop_timer)) {
+        asm("WFI"); // Free to do other work between ticks
+    }
+    asm("BKPT #0"); // LEDs blinked for 10 s and stopped
+}
+
 //Stuff for blinky
 #define RCC_BASE 0x40023800
 #define GPIOA_BASE 0x40020000
@@ -316,7 +415,16 @@ void _start() {
     // tal_set_pin(YELLOW_LED, 1);
     
 
+    clock_config_t clock_config;
+    if (!clock_config_480mhz(0, &clock_config) || !clock_init(&clock_config)) {
+        asm("BKPT #0");
+    }
+    time_init();
+
     //test_pwm();
+    //test_cm4();
+    //test_ipc();
+    //test_swtimer();
     test_uart();
     //test_spi();
     //blinky();
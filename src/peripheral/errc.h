@@ -43,6 +43,9 @@ enum ti_errc_t {
   TI_ERRC_MUTEX_UNLOCKED, /** @brief Failed to disable EXTI ISR because mutex is unlocked */
   TI_ERRC_MUTEX_TIMEOUT, /** @brief Failed to disable EXTI ISR because mutex timed out */
   TI_ERRC_SPI_NOT_LOCKED,
+  TI_ERRC_SPI_BUSY, /** @brief SPI instance already has a transfer in progress */
+  TI_ERRC_SPI_NO_DMA, /** @brief SPI instance was initialized without DMA streams */
+  TI_ERRC_SPI_QUEUE_FULL, /** @brief SPI instance's transaction queue is full */
 };
 
 /**
@@ -22,6 +22,7 @@
 #include "peripheral/pwm.h"
 #include "peripheral/errc.h"
 #include "peripheral/gpio.h"
+#include "internal/clock.h"
 #include "internal/mmio.h"
 
 
@@ -48,7 +49,7 @@ static enum ti_errc_t check_pwm_config_validity(struct ti_pwm_config_t pwm_confi
     }
 
     int32_t freq_prescaler = pwm_config.clock_freq / pwm_config.freq;
-    if (freq_prescaler == 0 || freq_prescaler > UINT16_MAX) {
+    if (freq_prescaler == 0) {
         return TI_ERRC_INVALID_ARG;
     }
 
@@ -171,6 +172,11 @@ void ti_set_pwm(struct ti_pwm_config_t pwm_config, enum ti_errc_t* errc) {
         return;
     }
 
+    // TIM2-5 are clocked from the APB1 timer clock
+    if (pwm_config.clock_freq == 0) {
+        pwm_config.clock_freq = (int32_t)clock_get_hz(CLOCK_TIM_APB1);
+    }
+
     enum ti_errc_t validation = check_pwm_config_validity(pwm_config); 
 
     if (validation != TI_ERRC_NONE) {
@@ -193,8 +199,15 @@ void ti_set_pwm(struct ti_pwm_config_t pwm_config, enum ti_errc_t* errc) {
     bool is_32bit_timer = (pwm_config.instance == 2 || pwm_config.instance == 5);
     const field32_t arr_field = is_32bit_timer ? G_TIMx_ARR_ARR_32B : G_TIMx_ARR_ARR_L;
 
+    // Divide the counter clock down until one period fits in 16 bits, so fast timer clocks
+    // still reach low PWM frequencies on TIM3/4
+    int32_t counter_prescaler = (pwm_config.clock_freq / pwm_config.freq) / (UINT16_MAX + 1);
+    WRITE_FIELD(G_TIMx_PSC[pwm_config.instance], G_TIMx_PSC_PSC, counter_prescaler);
+    SET_WO_FIELD(G_TIMx_EGR[pwm_config.instance], G_TIMx_EGR_UG);
+
     // Set frequency of timer (using the correct 16-bit or 32-bit field)
-    int32_t freq_prescaler = (pwm_config.clock_freq / pwm_config.freq) - 1; 
+    int32_t counter_freq = pwm_config.clock_freq / (counter_prescaler + 1);
+    int32_t freq_prescaler = (counter_freq / pwm_config.freq) - 1; 
 
     WRITE_FIELD(G_TIMx_ARR[pwm_config.instance], arr_field, freq_prescaler);
     
@@ -34,7 +34,7 @@ struct ti_pwm_config_t {
     int32_t instance;
     int32_t freq;
     int32_t duty;
-    int32_t clock_freq;
+    int32_t clock_freq; // Timer kernel clock in Hz, or 0 to read it from the RCC
 };
 
 
@@ -0,0 +1,597 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2024 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/peripheral/qspi.c
+ * @authors Charles Faisandier
+ * @brief QUADSPI driver implementation.
+ */
+#include "qspi.h"
+#include "../internal/cache.h"
+#include "../internal/dma.h"
+#include "../internal/interrupt.h"
+#include "../internal/mmio.h"
+#include "gpio.h"
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+// CCR FMODE encodings
+#define QSPI_FMODE_WRITE 0U
+#define QSPI_FMODE_READ 1U
+#define QSPI_FMODE_POLL 2U
+#define QSPI_FMODE_MAPPED 3U
+
+// CCR ADSIZE encodings
+#define QSPI_ADSIZE_24 2U
+#define QSPI_ADSIZE_32 3U
+
+// The FIFO threshold flag (and so each MDMA request) covers this many bytes.
+#define QSPI_FIFO_BURST 4U
+
+// Size of the controller's FIFO in bytes.
+#define QSPI_FIFO_SIZE 32U
+
+// Clocks between status register reads while waiting for the flash to finish.
+#define QSPI_POLL_INTERVAL 16U
+
+// Clocks the controller keeps CS low after prefetching in memory mapped mode.
+#define QSPI_MAPPED_IDLE_TIMEOUT 0x400U
+
+// NVIC priority of the QUADSPI interrupt. Flash logging is background work.
+#define QSPI_IRQ_PRIORITY 10U
+
+// Status polls allowed for blocking steps.
+#define QSPI_TIMEOUT 1000000U
+
+typedef enum {
+  QSPI_STATE_IDLE,
+  QSPI_STATE_BLOCKING, // A blocking command owns the controller
+  QSPI_STATE_STARTING, // The next queued operation is being started
+  QSPI_STATE_WRITE,    // A page program or erase command is going out
+  QSPI_STATE_POLL,     // Waiting for the flash to clear WIP
+  QSPI_STATE_READ,     // An async read is running
+  QSPI_STATE_MAPPED,
+} qspi_state_t;
+
+typedef struct {
+  uint8_t instruction; // Program or erase command
+  uint32_t address;
+  const uint8_t *data; // NULL for erases
+  size_t size;
+  qspi_callback_t callback;
+  void *context;
+} qspi_op_t;
+
+/**************************************************************************************************
+ * @section Private Data
+ **************************************************************************************************/
+static volatile qspi_state_t qspi_state = QSPI_STATE_IDLE;
+static bool qspi_ready = false;
+static uint32_t qspi_adsize = QSPI_ADSIZE_24;
+static uint64_t qspi_flash_size = 0; // Bytes, set by qspi_init()
+
+// Program/erase queue. The operation at head is running whenever the state is WRITE or POLL.
+static qspi_op_t qspi_queue[QSPI_QUEUE_LEN];
+static uint32_t qspi_head = 0;
+static volatile uint32_t qspi_count = 0;
+static size_t qspi_offset = 0; // Bytes of the running program operation already written
+static size_t qspi_chunk = 0;  // Size of the page being written
+static bool qspi_dma_failed = false;
+
+// Completion of the running async read
+static qspi_callback_t qspi_read_callback = NULL;
+static void *qspi_read_context = NULL;
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+static uint32_t qspi_ccr(uint8_t instruction, qspi_lines_t imode, qspi_lines_t admode,
+                         qspi_lines_t dmode, uint32_t dummy, uint32_t fmode) {
+  return TO_FIELD(instruction, QUADSPI_CCR_INSTRUCTION) |
+         TO_FIELD((uint32_t)imode, QUADSPI_CCR_IMODE) |
+         TO_FIELD((uint32_t)admode, QUADSPI_CCR_ADMODE) |
+         TO_FIELD(qspi_adsize, QUADSPI_CCR_ADSIZE) |
+         TO_FIELD(dummy, QUADSPI_CCR_DCYC) |
+         TO_FIELD((uint32_t)dmode, QUADSPI_CCR_DMODE) |
+         TO_FIELD(fmode, QUADSPI_CCR_FMODE);
+}
+
+static bool qspi_wait_idle(void) {
+  uint32_t timeout = QSPI_TIMEOUT;
+  while (READ_FIELD(QUADSPI_SR, QUADSPI_SR_BUSY)) {
+    if (--timeout == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Waits for the command in flight to complete and clears its flags.
+static bool qspi_wait_complete(void) {
+  uint32_t timeout = QSPI_TIMEOUT;
+  while (!READ_FIELD(QUADSPI_SR, QUADSPI_SR_TCF)) {
+    if (--timeout == 0) {
+      return false;
+    }
+  }
+  bool error = READ_FIELD(QUADSPI_SR, QUADSPI_SR_TEF);
+  SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTCF);
+  SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTEF);
+  return !error;
+}
+
+// Claims the controller for a blocking or mapped use. Fails while anything else runs.
+static bool qspi_claim(qspi_state_t state) {
+  if (!qspi_ready) {
+    return false;
+  }
+  uint32_t primask = irq_save();
+  bool free = (qspi_state == QSPI_STATE_IDLE && qspi_count == 0);
+  if (free) {
+    qspi_state = state;
+  }
+  irq_restore(primask);
+  return free;
+}
+
+// Runs an indirect command on a claimed controller, moving data through the FIFO with word
+// accesses where possible.
+static bool qspi_indirect(const qspi_command_t *command, uint8_t *data, size_t size) {
+  bool has_data = (command->data_lines != QSPI_LINES_NONE);
+  if (has_data && (data == NULL || size == 0)) {
+    return false;
+  }
+  if (!qspi_wait_idle()) {
+    return false;
+  }
+  bool read = has_data && !command->write;
+  if (has_data) {
+    *QUADSPI_DLR = (uint32_t)size - 1U;
+  }
+  *QUADSPI_CCR = qspi_ccr(command->instruction, command->instruction_lines,
+                          command->address_lines, command->data_lines, command->dummy_cycles,
+                          read ? QSPI_FMODE_READ : QSPI_FMODE_WRITE);
+  if (command->address_lines != QSPI_LINES_NONE) {
+    *QUADSPI_AR = command->address;
+  }
+
+  volatile uint8_t *dr8 = (volatile uint8_t *)QUADSPI_DR;
+  size_t pos = 0;
+  uint32_t idle = QSPI_TIMEOUT;
+  while (has_data && pos < size) {
+    uint32_t level = READ_FIELD(QUADSPI_SR, QUADSPI_SR_FLEVEL);
+    size_t step = 0;
+    if (read) {
+      if (level >= 4U && size - pos >= 4U) {
+        uint32_t word = *QUADSPI_DR;
+        for (step = 0; step < 4U; step++) {
+          data[pos + step] = (uint8_t)(word >> (8U * step));
+        }
+      } else if (level > 0U) {
+        data[pos] = *dr8;
+        step = 1;
+      }
+    } else {
+      if (level + 4U <= QSPI_FIFO_SIZE && size - pos >= 4U) {
+        *QUADSPI_DR = (uint32_t)data[pos] | ((uint32_t)data[pos + 1] << 8) |
+                      ((uint32_t)data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24);
+        step = 4;
+      } else if (level < QSPI_FIFO_SIZE) {
+        *dr8 = data[pos];
+        step = 1;
+      }
+    }
+    if (step != 0) {
+      pos += step;
+      idle = QSPI_TIMEOUT;
+    } else if (--idle == 0) {
+      SET_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT);
+      return false;
+    }
+  }
+  return qspi_wait_complete();
+}
+
+static bool qspi_write_enable(void) {
+  qspi_command_t command = {
+      .instruction = QSPI_CMD_WRITE_ENABLE,
+      .instruction_lines = QSPI_LINES_SINGLE,
+      .address_lines = QSPI_LINES_NONE,
+      .data_lines = QSPI_LINES_NONE,
+  };
+  return qspi_indirect(&command, NULL, 0);
+}
+
+static void qspi_dma_callback(bool success, void *context);
+
+// Takes the operation at the head of the queue off it.
+static qspi_op_t qspi_pop(void) {
+  uint32_t primask = irq_save();
+  qspi_op_t op = qspi_queue[qspi_head];
+  qspi_head = (qspi_head + 1) % QSPI_QUEUE_LEN;
+  qspi_count--;
+  qspi_offset = 0;
+  irq_restore(primask);
+  return op;
+}
+
+// Starts the next step of the operation at the head of the queue. The caller owns the
+// controller through the STARTING state, so this runs with interrupts enabled; an operation
+// queued meanwhile is picked up here. Goes back to IDLE once the queue is empty. Returns the
+// operation that failed to start, if any, so the caller can report it once the queue is
+// moving again.
+static bool qspi_start_step(qspi_op_t *failed) {
+  uint32_t primask = irq_save();
+  bool empty = (qspi_count == 0);
+  if (empty) {
+    qspi_state = QSPI_STATE_IDLE;
+  }
+  irq_restore(primask);
+  if (empty) {
+    return false;
+  }
+  qspi_op_t *op = &qspi_queue[qspi_head];
+  qspi_dma_failed = false;
+  bool started = qspi_write_enable();
+  if (started && op->data == NULL) {
+    // Erase: instruction and address only. The command starts on the AR write, or on the CCR
+    // write when there is no address.
+    bool chip = (op->instruction == QSPI_CMD_ERASE_CHIP);
+    *QUADSPI_CCR = qspi_ccr(op->instruction, QSPI_LINES_SINGLE,
+                            chip ? QSPI_LINES_NONE : QSPI_LINES_SINGLE, QSPI_LINES_NONE, 0,
+                            QSPI_FMODE_WRITE);
+    SET_FIELD(QUADSPI_CR, QUADSPI_CR_TCIE);
+    qspi_state = QSPI_STATE_WRITE;
+    if (!chip) {
+      *QUADSPI_AR = op->address;
+    }
+    return false;
+  }
+  if (started) {
+    // Program one page. The MDMA refills the FIFO every time it has room for a burst.
+    uint32_t address = op->address + (uint32_t)qspi_offset;
+    size_t page_left = QSPI_PAGE_SIZE - (address % QSPI_PAGE_SIZE);
+    size_t left = op->size - qspi_offset;
+    qspi_chunk = (left < page_left) ? left : page_left;
+    dma_mdma_periph_transfer_t transfer = {
+        .request = DMA_MDMA_REQ_QUADSPI_FIFO,
+        .periph = QUADSPI_DR,
+        .mem = (void *)(op->data + qspi_offset),
+        .size = qspi_chunk,
+        .burst = QSPI_FIFO_BURST,
+        .to_periph = true,
+        .callback = qspi_dma_callback,
+        .context = NULL,
+    };
+    *QUADSPI_DLR = (uint32_t)qspi_chunk - 1U;
+    *QUADSPI_CCR = qspi_ccr(QSPI_CMD_QUAD_PROGRAM, QSPI_LINES_SINGLE, QSPI_LINES_SINGLE,
+                            QSPI_LINES_QUAD, 0, QSPI_FMODE_WRITE);
+    started = dma_mdma_periph_start(&transfer);
+    if (started) {
+      SET_FIELD(QUADSPI_CR, QUADSPI_CR_DMAEN);
+      SET_FIELD(QUADSPI_CR, QUADSPI_CR_TCIE);
+      qspi_state = QSPI_STATE_WRITE;
+      *QUADSPI_AR = address;
+      return false;
+    }
+  }
+
+  // Could not start: drop the operation.
+  *failed = qspi_pop();
+  return true;
+}
+
+// Starts queued operations until one is running, reporting any that fail to start. Expects
+// the state to be STARTING.
+static void qspi_start(void) {
+  qspi_op_t failed;
+  while (qspi_start_step(&failed)) {
+    if (failed.callback != NULL) {
+      failed.callback(false, failed.context);
+    }
+  }
+}
+
+// Retires the operation at head and starts the next one before reporting it, so the flash
+// stays busy while the callback runs.
+static void qspi_retire(bool success) {
+  qspi_op_t done = qspi_pop();
+  qspi_state = QSPI_STATE_STARTING;
+  qspi_start();
+  if (done.callback != NULL) {
+    done.callback(success, done.context);
+  }
+}
+
+// Polls the status register in hardware until WIP clears, then raises the status match
+// interrupt. The command starts on the CCR write since it has no address.
+static void qspi_start_poll(void) {
+  *QUADSPI_PSMKR = QSPI_STATUS_WIP;
+  *QUADSPI_PSMAR = 0U;
+  *QUADSPI_PIR = QSPI_POLL_INTERVAL;
+  *QUADSPI_DLR = 0U;
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_APMS);
+  CLR_FIELD(QUADSPI_CR, QUADSPI_CR_PMM);
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_SMIE);
+  qspi_state = QSPI_STATE_POLL;
+  *QUADSPI_CCR = qspi_ccr(QSPI_CMD_READ_STATUS, QSPI_LINES_SINGLE, QSPI_LINES_NONE,
+                          QSPI_LINES_SINGLE, 0, QSPI_FMODE_POLL);
+}
+
+static void qspi_dma_callback(bool success, void *context) {
+  (void)context;
+  if (qspi_state == QSPI_STATE_READ) {
+    // Every byte is in memory, so the read is done.
+    CLR_FIELD(QUADSPI_CR, QUADSPI_CR_DMAEN);
+    if (!success) {
+      SET_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT);
+    }
+    qspi_wait_idle();
+    SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTCF);
+    qspi_callback_t callback = qspi_read_callback;
+    void *callback_context = qspi_read_context;
+    qspi_state = QSPI_STATE_STARTING;
+    qspi_start();
+    if (callback != NULL) {
+      callback(success, callback_context);
+    }
+  } else if (qspi_state == QSPI_STATE_WRITE && !success) {
+    // Aborting raises the transfer complete interrupt, which retires the operation.
+    qspi_dma_failed = true;
+    SET_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT);
+  }
+}
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+bool qspi_init(const qspi_config_t *config) {
+  if (config == NULL || config->flash_size_log2 < 10 || config->flash_size_log2 > 32 ||
+      config->cs_high_cycles < 1 || config->cs_high_cycles > 8) {
+    return false;
+  }
+
+  const qspi_pin_t *pins[] = {&config->clk, &config->ncs, &config->io[0], &config->io[1],
+                              &config->io[2], &config->io[3]};
+  for (size_t i = 0; i < sizeof(pins) / sizeof(pins[0]); i++) {
+    tal_enable_clock(pins[i]->pin);
+    tal_set_mode(pins[i]->pin, 2);
+    tal_alternate_mode(pins[i]->pin, pins[i]->af);
+    tal_set_speed(pins[i]->pin, 3);
+  }
+  tal_pull_pin(config->ncs.pin, 1); // Keep the flash deselected while the pin floats
+
+  SET_FIELD(RCC_AHB3ENR, RCC_AHB3ENR_QSPIEN);
+  SET_FIELD(RCC_AHB3RSTR, RCC_AHB3RSTR_QSPIRST);
+  CLR_FIELD(RCC_AHB3RSTR, RCC_AHB3RSTR_QSPIRST);
+
+  *QUADSPI_CR = TO_FIELD(config->prescaler, QUADSPI_CR_PRESCALER) |
+                TO_FIELD(QSPI_FIFO_BURST - 1U, QUADSPI_CR_FTHRES) |
+                TO_FIELD(config->sample_shift ? 1U : 0U, QUADSPI_CR_SSHIFT) |
+                QUADSPI_CR_TEIE.msk;
+  *QUADSPI_DCR = TO_FIELD(config->flash_size_log2 - 1U, QUADSPI_DCR_FSIZE) |
+                 TO_FIELD(config->cs_high_cycles - 1U, QUADSPI_DCR_CSHT);
+  *QUADSPI_LPTR = QSPI_MAPPED_IDLE_TIMEOUT;
+  qspi_adsize = (config->flash_size_log2 > 24) ? QSPI_ADSIZE_32 : QSPI_ADSIZE_24;
+  qspi_flash_size = (uint64_t)1U << config->flash_size_log2;
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_EN);
+
+  qspi_head = 0;
+  qspi_count = 0;
+  qspi_offset = 0;
+  qspi_state = QSPI_STATE_IDLE;
+  qspi_ready = true;
+  irq_set_priority(QUADSPI_IRQ_NUM, QSPI_IRQ_PRIORITY);
+  irq_enable(QUADSPI_IRQ_NUM);
+  return true;
+}
+
+bool qspi_command(const qspi_command_t *command, uint8_t *data, size_t size) {
+  if (command == NULL || !qspi_claim(QSPI_STATE_BLOCKING)) {
+    return false;
+  }
+  bool ok = qspi_indirect(command, data, size);
+  qspi_state = QSPI_STATE_IDLE;
+  return ok;
+}
+
+bool qspi_read(uint32_t address, void *dest, size_t size) {
+  qspi_command_t command = {
+      .instruction = QSPI_CMD_QUAD_READ,
+      .instruction_lines = QSPI_LINES_SINGLE,
+      .address_lines = QSPI_LINES_SINGLE,
+      .address = address,
+      .data_lines = QSPI_LINES_QUAD,
+      .dummy_cycles = QSPI_QUAD_READ_DUMMY,
+      .write = false,
+  };
+  return qspi_command(&command, (uint8_t *)dest, size);
+}
+
+bool qspi_read_async(uint32_t address, void *dest, size_t size, qspi_callback_t callback,
+                     void *context) {
+  if (dest == NULL || size == 0 || size > DMA_MDMA_MAX_BLOCK) {
+    return false;
+  }
+  if (!qspi_claim(QSPI_STATE_READ)) {
+    return false;
+  }
+  if (!qspi_wait_idle()) {
+    qspi_state = QSPI_STATE_IDLE;
+    return false;
+  }
+  qspi_read_callback = callback;
+  qspi_read_context = context;
+  dma_mdma_periph_transfer_t transfer = {
+      .request = DMA_MDMA_REQ_QUADSPI_FIFO,
+      .periph = QUADSPI_DR,
+      .mem = dest,
+      .size = size,
+      .burst = QSPI_FIFO_BURST,
+      .to_periph = false,
+      .callback = qspi_dma_callback,
+      .context = NULL,
+  };
+  *QUADSPI_DLR = (uint32_t)size - 1U;
+  *QUADSPI_CCR = qspi_ccr(QSPI_CMD_QUAD_READ, QSPI_LINES_SINGLE, QSPI_LINES_SINGLE,
+                          QSPI_LINES_QUAD, QSPI_QUAD_READ_DUMMY, QSPI_FMODE_READ);
+  if (!dma_mdma_periph_start(&transfer)) {
+    qspi_state = QSPI_STATE_IDLE;
+    return false;
+  }
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_DMAEN);
+  *QUADSPI_AR = address;
+  return true;
+}
+
+static bool qspi_enqueue(const qspi_op_t *op) {
+  if (!qspi_ready) {
+    return false;
+  }
+  uint32_t primask = irq_save();
+  if (qspi_count >= QSPI_QUEUE_LEN || qspi_state == QSPI_STATE_MAPPED) {
+    irq_restore(primask);
+    return false;
+  }
+  qspi_queue[(qspi_head + qspi_count) % QSPI_QUEUE_LEN] = *op;
+  qspi_count++;
+  // Take the controller if nothing is running. Starting blocks on the write enable command,
+  // so it runs after interrupts are unmasked again.
+  bool start = (qspi_state == QSPI_STATE_IDLE);
+  if (start) {
+    qspi_state = QSPI_STATE_STARTING;
+  }
+  irq_restore(primask);
+  if (start) {
+    qspi_start();
+  }
+  return true;
+}
+
+bool qspi_program(uint32_t address, const void *data, size_t size, qspi_callback_t callback,
+                  void *context) {
+  // Addresses past the end of the flash are refused by the controller (TEF), so catch them
+  // here rather than from the interrupt.
+  if (data == NULL || size == 0 || (uint64_t)address + size > qspi_flash_size) {
+    return false;
+  }
+  qspi_op_t op = {
+      .instruction = QSPI_CMD_QUAD_PROGRAM,
+      .address = address,
+      .data = (const uint8_t *)data,
+      .size = size,
+      .callback = callback,
+      .context = context,
+  };
+  return qspi_enqueue(&op);
+}
+
+bool qspi_erase(uint32_t address, qspi_erase_t kind, qspi_callback_t callback, void *context) {
+  static const uint8_t instructions[] = {
+      [QSPI_ERASE_4K] = QSPI_CMD_ERASE_4K,
+      [QSPI_ERASE_64K] = QSPI_CMD_ERASE_64K,
+      [QSPI_ERASE_CHIP] = QSPI_CMD_ERASE_CHIP,
+  };
+  if (kind > QSPI_ERASE_CHIP || (kind != QSPI_ERASE_CHIP && address >= qspi_flash_size)) {
+    return false;
+  }
+  qspi_op_t op = {
+      .instruction = instructions[kind],
+      .address = address,
+      .data = NULL,
+      .size = 0,
+      .callback = callback,
+      .context = context,
+  };
+  return qspi_enqueue(&op);
+}
+
+bool qspi_busy(void) {
+  return qspi_count != 0 || qspi_state == QSPI_STATE_READ ||
+         qspi_state == QSPI_STATE_BLOCKING;
+}
+
+bool qspi_memory_map(void) {
+  if (!qspi_claim(QSPI_STATE_MAPPED)) {
+    return false;
+  }
+  if (!qspi_wait_idle()) {
+    qspi_state = QSPI_STATE_IDLE;
+    return false;
+  }
+  // Release CS once the prefetch buffer has been idle for a while, so the flash can drop
+  // back to standby between bursts of reads.
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_TCEN);
+  *QUADSPI_CCR = qspi_ccr(QSPI_CMD_QUAD_READ, QSPI_LINES_SINGLE, QSPI_LINES_SINGLE,
+                          QSPI_LINES_QUAD, QSPI_QUAD_READ_DUMMY, QSPI_FMODE_MAPPED);
+  // The mapped region is cacheable, and may have been programmed since it was last mapped.
+  cache_clean_invalidate_all();
+  return true;
+}
+
+void qspi_memory_unmap(void) {
+  if (qspi_state != QSPI_STATE_MAPPED) {
+    return;
+  }
+  SET_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT);
+  uint32_t timeout = QSPI_TIMEOUT;
+  while (READ_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT) && --timeout > 0) {
+  }
+  CLR_FIELD(QUADSPI_CR, QUADSPI_CR_TCEN);
+  SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTCF);
+  qspi_state = QSPI_STATE_IDLE;
+}
+
+/**************************************************************************************************
+ * @section Interrupt Handlers
+ **************************************************************************************************/
+void quadspi_irq_handler(void) {
+  if (qspi_state == QSPI_STATE_WRITE &&
+      (READ_FIELD(QUADSPI_SR, QUADSPI_SR_TCF) || READ_FIELD(QUADSPI_SR, QUADSPI_SR_TEF))) {
+    // The page or erase command has been sent; the flash is now busy with it. A command the
+    // controller refused raises TEF without TCF, so abort it to get back to idle.
+    bool error = qspi_dma_failed || READ_FIELD(QUADSPI_SR, QUADSPI_SR_TEF);
+    if (!READ_FIELD(QUADSPI_SR, QUADSPI_SR_TCF)) {
+      SET_FIELD(QUADSPI_CR, QUADSPI_CR_ABORT);
+      qspi_wait_idle();
+    }
+    SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTCF);
+    SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTEF);
+    CLR_FIELD(QUADSPI_CR, QUADSPI_CR_TCIE);
+    CLR_FIELD(QUADSPI_CR, QUADSPI_CR_DMAEN);
+    if (error) {
+      dma_mdma_periph_abort();
+      qspi_retire(false);
+    } else {
+      qspi_start_poll();
+    }
+  } else if (qspi_state == QSPI_STATE_POLL && READ_FIELD(QUADSPI_SR, QUADSPI_SR_SMF)) {
+    SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CSMF);
+    CLR_FIELD(QUADSPI_CR, QUADSPI_CR_SMIE);
+    qspi_wait_idle();
+    const qspi_op_t *op = &qspi_queue[qspi_head];
+    qspi_offset += qspi_chunk;
+    qspi_chunk = 0;
+    if (op->data != NULL && qspi_offset < op->size) {
+      qspi_state = QSPI_STATE_STARTING;
+      qspi_start(); // Next page of the same operation
+    } else {
+      qspi_retire(true);
+    }
+  } else if (READ_FIELD(QUADSPI_SR, QUADSPI_SR_TEF)) {
+    SET_WO_FIELD(QUADSPI_FCR, QUADSPI_FCR_CTEF);
+  }
+}
@@ -0,0 +1,197 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2024 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/peripheral/qspi.h
+ * @authors Charles Faisandier
+ * @brief QUADSPI driver for external NOR flash.
+ *
+ * Uses the common (W25Q / MT25Q / IS25LP) command set: quad output fast read (1-1-4) and quad
+ * page program (1-1-4). The flash's quad enable bit is vendor specific and has to be set with
+ * qspi_command() before quad transfers are used. Flashes larger than 16 MiB use 4 byte
+ * addresses, so they must also be switched to 4 byte address mode first.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+// Where the flash appears while memory mapped (see qspi_memory_map()).
+#define QSPI_MEM_BASE 0x90000000U
+
+// Program operations are split at page boundaries.
+#define QSPI_PAGE_SIZE 256U
+
+// Maximum number of program/erase operations waiting in the queue, including the running one.
+#define QSPI_QUEUE_LEN 16
+
+// Flash commands
+#define QSPI_CMD_WRITE_ENABLE 0x06U
+#define QSPI_CMD_READ_STATUS 0x05U
+#define QSPI_CMD_QUAD_READ 0x6BU    // Quad output fast read, 1-1-4
+#define QSPI_CMD_QUAD_PROGRAM 0x32U // Quad input page program, 1-1-4
+#define QSPI_CMD_ERASE_4K 0x20U
+#define QSPI_CMD_ERASE_64K 0xD8U
+#define QSPI_CMD_ERASE_CHIP 0xC7U
+
+// Dummy cycles between the address and the data of a quad output fast read.
+#define QSPI_QUAD_READ_DUMMY 8U
+
+// Status register write-in-progress bit.
+#define QSPI_STATUS_WIP 0x01U
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+// Number of data lines used by a command phase, in the CCR encoding.
+typedef enum {
+  QSPI_LINES_NONE = 0, // Phase is skipped
+  QSPI_LINES_SINGLE,
+  QSPI_LINES_DUAL,
+  QSPI_LINES_QUAD,
+} qspi_lines_t;
+
+typedef enum {
+  QSPI_ERASE_4K,
+  QSPI_ERASE_64K,
+  QSPI_ERASE_CHIP,
+} qspi_erase_t;
+
+typedef struct {
+  int32_t pin;
+  uint8_t af; // Alternate function, AF9 or AF10 depending on the pin
+} qspi_pin_t;
+
+typedef struct {
+  qspi_pin_t clk;
+  qspi_pin_t ncs;
+  qspi_pin_t io[4];
+  uint8_t prescaler;       // QUADSPI clock = kernel clock (HCLK3) / (prescaler + 1)
+  uint8_t flash_size_log2; // log2 of the flash size in bytes, e.g. 24 for 16 MiB
+  uint8_t cs_high_cycles;  // Minimum CS high time between commands, 1-8 clocks
+  bool sample_shift;       // Sample half a clock later, to allow for long traces
+} qspi_config_t;
+
+/**
+ * @brief A single indirect mode command (see qspi_command()).
+ */
+typedef struct {
+  uint8_t instruction;
+  qspi_lines_t instruction_lines;
+  qspi_lines_t address_lines; // QSPI_LINES_NONE for commands without an address
+  uint32_t address;
+  qspi_lines_t data_lines;    // QSPI_LINES_NONE for commands without data
+  uint8_t dummy_cycles;
+  bool write;                 // Data is sent to the flash rather than read from it
+} qspi_command_t;
+
+typedef void (*qspi_callback_t)(bool success, void *context);
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+/**
+ * @brief Initializes the QUADSPI controller and its pins. dma_init() must have been called.
+ *
+ * @param config Controller configuration.
+ * @return true on success, false if the configuration is invalid.
+ */
+bool qspi_init(const qspi_config_t *config);
+
+/**
+ * @brief Runs a command in indirect mode, blocking until it completes.
+ * Meant for status, ID and configuration commands.
+ *
+ * @param command Command to run.
+ * @param data Data to send or receive. May be NULL if the command has no data phase.
+ * @param size Number of data bytes.
+ * @return true on success, false if the driver is busy or memory mapped, or the arguments are
+ *         invalid.
+ */
+bool qspi_command(const qspi_command_t *command, uint8_t *data, size_t size);
+
+/**
+ * @brief Reads from the flash with a quad output fast read, blocking until it completes.
+ *
+ * @param address Flash address.
+ * @param dest Destination buffer.
+ * @param size Number of bytes.
+ * @return true on success, false if the driver is busy or memory mapped.
+ */
+bool qspi_read(uint32_t address, void *dest, size_t size);
+
+/**
+ * @brief Reads from the flash through the MDMA.
+ *
+ * @param address Flash address.
+ * @param dest Destination buffer. Must stay valid until the callback is invoked.
+ * @param size Number of bytes, at most DMA_MDMA_MAX_BLOCK.
+ * @param callback Invoked from interrupt context once the data is in @p dest. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if the read was started, false if the driver is busy or memory mapped.
+ */
+bool qspi_read_async(uint32_t address, void *dest, size_t size, qspi_callback_t callback,
+                     void *context);
+
+/**
+ * @brief Queues a program operation.
+ * The data is split at page boundaries; each page is fed to the controller by the MDMA, and
+ * the next one starts from the interrupt that sees the flash finish the previous one. The
+ * target range must have been erased.
+ *
+ * @param address Flash address.
+ * @param data Data to program. Must stay valid until the callback is invoked.
+ * @param size Number of bytes.
+ * @param callback Invoked from interrupt context once the data is programmed. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if the operation was queued, false if the queue is full, the driver is memory
+ *         mapped, or the arguments are invalid, including a range past the end of the flash.
+ */
+bool qspi_program(uint32_t address, const void *data, size_t size, qspi_callback_t callback,
+                  void *context);
+
+/**
+ * @brief Queues an erase operation. Runs in order with queued program operations.
+ *
+ * @param address Any address inside the sector or block to erase. Ignored for a chip erase.
+ * @param kind Size of the erase.
+ * @param callback Invoked from interrupt context once the erase is complete. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if the operation was queued, false if the queue is full, the driver is memory
+ *         mapped, or the arguments are invalid, including an address past the end of the flash.
+ */
+bool qspi_erase(uint32_t address, qspi_erase_t kind, qspi_callback_t callback, void *context);
+
+/**
+ * @brief Checks whether any queued operation or async read is still running.
+ * @return true while the controller is in use.
+ */
+bool qspi_busy(void);
+
+/**
+ * @brief Maps the flash into the address space at QSPI_MEM_BASE, read only.
+ * The controller prefetches sequential reads, so reading a log back is a plain memory access.
+ *
+ * @return true on success, false if an operation is still running.
+ */
+bool qspi_memory_map(void);
+
+/**
+ * @brief Leaves memory mapped mode so indirect commands can be used again.
+ */
+void qspi_memory_unmap(void);
@@ -24,12 +24,29 @@
 #include <stdint.h>
 // #include "mutex.h"
 #include "errc.h"
+#include "internal/clock.h"
 #include "internal/dma.h"
+#include "internal/interrupt.h"
 
 #define DATA_REG_SIZE 32
 #define MAX_DEVICES_PER_INSTANCE 5
 #define MAX_PRESCALER 256
 
+// Polls of SR allowed for EOT once the last frame has been received
+#define SPI_EOT_TIMEOUT 100000
+
+// Bytes the blocking path lets run ahead of the reads. Every byte in flight ends up in the RX
+// FIFO, so this is the smallest RX FIFO (SPI4-6) to rule out overruns.
+#define SPI_SYNC_MAX_INFLIGHT 8
+
+// NVIC priority of the SPI (end of transfer) interrupts, below DMA and above the UARTs.
+#define SPI_IRQ_PRIORITY 4U
+
+// CFG2 COMM values
+#define SPI_COMM_FULL_DUPLEX 0U
+#define SPI_COMM_TRANSMITTER 1U
+#define SPI_COMM_RECEIVER 2U
+
 /**************************************************************************************************
  * @section Internal Data Structures
  **************************************************************************************************/
@@ -65,6 +82,32 @@ static spi_context_t spi_context_arr[SPI_INSTANCE_COUNT + 1][MAX_DEVICES_PER_INS
 // Store config
 static spi_config_t configs[SPI_INSTANCE_COUNT + 1] = {0};
 
+// DMA streams given to spi_init. A zero instance means the SPI has no DMA streams.
+static dma_periph_streaminfo_t spi_to_dma[SPI_INSTANCE_COUNT + 1] = {0};
+
+// A queued job, plus the options only reachable through spi_transfer_async
+typedef struct {
+    spi_job_t job;
+    spi_callback_t transfer_callback; // Used instead of job.callback when set
+    bool src_inc;
+    bool dest_inc;
+} spi_queue_entry_t;
+
+// Per-instance job queue. The entry at head is the one on the bus while active is set, and is
+// passed to both DMA streams as their context.
+typedef struct {
+    spi_queue_entry_t entries[SPI_QUEUE_LEN];
+    uint8_t head;
+    volatile uint8_t count;
+    uint8_t num_complete; // Completion events seen for the job at head
+    uint8_t num_needed;   // Completion events that end the job at head
+    volatile bool active;
+    uint8_t mode;         // Mode and prescaler currently in CFG1/CFG2
+    uint16_t prescaler;
+} spi_queue_t;
+
+static spi_queue_t spi_queues[SPI_INSTANCE_COUNT + 1] = {0};
+
 // Mutexes/
 // struct ti_mutex_t mutex[SPI_INSTANCE_COUNT + 1];
 
@@ -84,9 +127,13 @@ inline static bool check_spi_config_validity(spi_config_t *spi_config) {
     if (spi_config->data_size != 8 && spi_config->data_size != 16) {
         return false;
     }
-    if (spi_config->baudrate_prescaler < 2 ||
-        spi_config->baudrate_prescaler > MAX_PRESCALER ||
-        spi_config->baudrate_prescaler & (spi_config->baudrate_prescaler - 1)) {
+    if (spi_config->baudrate_prescaler == 0) {
+        if (spi_config->max_sck_hz == 0) {
+            return false;
+        }
+    } else if (spi_config->baudrate_prescaler < 2 ||
+               spi_config->baudrate_prescaler > MAX_PRESCALER ||
+               spi_config->baudrate_prescaler & (spi_config->baudrate_prescaler - 1)) {
         return false;
     }
     if (spi_config->first_bit < 0 || spi_config->first_bit > 1) {
@@ -95,24 +142,306 @@ inline static bool check_spi_config_validity(spi_config_t *spi_config) {
     return true;
 }
 
-static void spi_dma_callback(bool success, spi_context_t *context) {
-    // De-init spi dma transaction if both streams are finished.
-    // spi_callback_t callback = context->callback;
-    // uint8_t instance = context->device.instance;
-    // if (success) {
-    //     context->num_complete++;
-    // } else {
-    //     spi_unblock(context->device);
-    //     callback(false);
-    // }
-    // if (context->num_complete == 2) {
-    //     // Disable DMA requests
-    //     CLR_FIELD(SPIx_CFG1[instance], SPIx_CFG1_RXDMAEN);
-    //     CLR_FIELD(SPIx_CFG1[instance], SPIx_CFG1_TXDMAEN);
-    //     context->num_complete = 0;
-    //     spi_unblock(context->device);
-    //     callback(true);
-    // }
+// Frequency of an instance's kernel clock, read from the RCC, or 0 if it is not known.
+static uint32_t spi_kernel_clock_hz(uint8_t instance) {
+    uint32_t source;
+    if (instance <= 3) {
+        // pll1_q, pll2_p, pll3_p, I2S_CKIN (external), per_ck
+        source = READ_FIELD(RCC_D2CCIP1R, RCC_D2CCIP1R_SPI123SRC);
+        switch (source) {
+            case 0:
+                return clock_get_hz(CLOCK_PLL1_Q);
+            case 1:
+                return clock_get_hz(CLOCK_PLL2_P);
+            case 2:
+                return clock_get_hz(CLOCK_PLL3_P);
+            case 4:
+                return clock_get_hz(CLOCK_PER);
+            default:
+                return 0;
+        }
+    }
+    // SPI4/5 and SPI6 share an encoding: their APB clock, pll2_q, pll3_q, hsi, csi, hse
+    source = (instance == 6) ? READ_FIELD(RCC_D3CCIPR, RCC_D3CCIPR_SPI6SRC)
+                             : READ_FIELD(RCC_D2CCIP1R, RCC_D2CCIP1R_SPI45SRC);
+    switch (source) {
+        case 0:
+            return clock_get_hz((instance == 6) ? CLOCK_PCLK4 : CLOCK_PCLK2);
+        case 1:
+            return clock_get_hz(CLOCK_PLL2_Q);
+        case 2:
+            return clock_get_hz(CLOCK_PLL3_Q);
+        case 3:
+            return clock_get_hz(CLOCK_HSI);
+        case 4:
+            return clock_get_hz(CLOCK_CSI);
+        case 5:
+            return clock_get_hz(CLOCK_HSE);
+        default:
+            return 0;
+    }
+}
+
+// Smallest prescaler that keeps SCK at or below max_sck_hz, or 0 if there is none.
+static uint16_t spi_prescaler_for_sck(uint8_t instance, uint32_t max_sck_hz) {
+    uint32_t kernel_hz = spi_kernel_clock_hz(instance);
+    if (kernel_hz == 0) {
+        return 0;
+    }
+    for (uint16_t prescaler = 2; prescaler <= MAX_PRESCALER; prescaler *= 2) {
+        if (kernel_hz / prescaler <= max_sck_hz) {
+            return prescaler;
+        }
+    }
+    return 0;
+}
+
+static void spi_write_mode(uint8_t instance, uint8_t mode) {
+    switch (mode) {
+        case (0):
+            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
+            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
+            break;
+        case (1):
+            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
+            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
+            break;
+        case (2):
+            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
+            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
+            break;
+        case (3):
+            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
+            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
+            break;
+    }
+}
+
+static void spi_write_prescaler(uint8_t instance, uint16_t prescaler) {
+    switch (prescaler) {
+        case (256):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b111);
+            break;
+        case (128):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b110);
+            break;
+        case (64):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b101);
+            break;
+        case (32):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b100);
+            break;
+        case (16):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b011);
+            break;
+        case (8):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b010);
+            break;
+        case (4):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b001);
+            break;
+        case (2):
+            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b000);
+            break;
+    }
+}
+
+// Ends the transfer on an instance: waits for the last frame to leave and leaves the controller
+// enabled with no transfer size, as spi_init does.
+static void spi_end_transfer(uint8_t instance, uint32_t timeout) {
+    while (!READ_FIELD(SPIx_SR[instance], SPIx_SR_EOT) && --timeout > 0) {
+    }
+    SET_WO_FIELD(SPIx_IFCR[instance], SPIx_IFCR_EOTC);
+    SET_WO_FIELD(SPIx_IFCR[instance], SPIx_IFCR_TXTFC);
+    SET_WO_FIELD(SPIx_IFCR[instance], SPIx_IFCR_OVRC);
+    CLR_FIELD(SPIx_IER[instance], SPIx_IER_EOTIE);
+    CLR_FIELD(SPIx_CFG1[instance], SPIx_CFG1_RXDMAEN);
+    CLR_FIELD(SPIx_CFG1[instance], SPIx_CFG1_TXDMAEN);
+    CLR_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+    WRITE_FIELD(SPIx_CR2[instance], SPIx_CR2_TSIZE, 0U);
+    SET_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+}
+
+// Frame access for the blocking path, which handles both 8 and 16 bit frames
+static inline uint32_t spi_frame_get(const void *buff, size_t index, size_t frame_bytes) {
+    return (frame_bytes == 2) ? ((const uint16_t *)buff)[index] : ((const uint8_t *)buff)[index];
+}
+
+static inline void spi_frame_put(void *buff, size_t index, size_t frame_bytes, uint32_t value) {
+    if (frame_bytes == 2) {
+        ((uint16_t *)buff)[index] = (uint16_t)value;
+    } else {
+        ((uint8_t *)buff)[index] = (uint8_t)value;
+    }
+}
+
+static void spi_finish_entry(const spi_queue_entry_t *entry, bool success) {
+    if (entry->transfer_callback != NULL) {
+        entry->transfer_callback(success);
+    } else if (entry->job.callback != NULL) {
+        entry->job.callback(success, entry->job.context);
+    }
+}
+
+// Programs the simplex/duplex mode for a transfer. A missing buffer turns the transfer into a
+// simplex one, so no dummy frames are moved and no RX FIFO has to be drained. Receive-only
+// masters clock on their own, so MASRX holds the clock rather than overrunning the RX FIFO.
+// Called with SPE cleared.
+static void spi_write_comm(uint8_t instance, bool tx, bool rx) {
+    uint32_t comm = (tx && rx) ? SPI_COMM_FULL_DUPLEX
+                               : (tx ? SPI_COMM_TRANSMITTER : SPI_COMM_RECEIVER);
+    WRITE_FIELD(SPIx_CFG2[instance], SPIx_CFG2_COMM, comm);
+    WRITE_FIELD(SPIx_CR1[instance], SPIx_CR1_MASRX, (uint32_t)!tx);
+}
+
+// Puts the job at the head of the queue on the bus, if the bus is free. Called with interrupts
+// masked, or from the DMA interrupt. Jobs whose DMA transfers cannot be started are failed
+// and skipped.
+static void spi_queue_start(uint8_t instance) {
+    spi_queue_t *queue = &spi_queues[instance];
+    while (!queue->active && queue->count > 0) {
+        spi_queue_entry_t *entry = &queue->entries[queue->head];
+        const spi_job_t *job = &entry->job;
+        uint8_t mode = (job->mode == SPI_MODE_DEFAULT) ? configs[instance].mode : job->mode;
+        uint16_t prescaler = (job->baudrate_prescaler == 0) ? configs[instance].baudrate_prescaler
+                                                            : job->baudrate_prescaler;
+        bool tx = (job->source != NULL);
+        bool rx = (job->dest != NULL);
+
+        dma_transfer_t tx_transfer = {
+            .instance = spi_to_dma[instance].tx_instance,
+            .stream = spi_to_dma[instance].tx_stream,
+            .src = job->source,
+            .dest = (void *)SPIx_TXDR[instance],
+            .size = job->size,
+            .context = entry,
+            .disable_mem_inc = !entry->src_inc,
+        };
+        dma_transfer_t rx_transfer = {
+            .instance = spi_to_dma[instance].rx_instance,
+            .stream = spi_to_dma[instance].rx_stream,
+            .src = (const void *)SPIx_RXDR[instance],
+            .dest = job->dest,
+            .size = job->size,
+            .context = entry,
+            .disable_mem_inc = !entry->dest_inc,
+        };
+
+        // CFG1/CFG2 and TSIZE can only be written while the controller is disabled. RX DMA is
+        // armed first so the first received frame always has somewhere to go, TX DMA is
+        // enabled only once both streams are running, as the reference manual requires.
+        CLR_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+        if (mode != queue->mode) {
+            spi_write_mode(instance, mode);
+            queue->mode = mode;
+        }
+        if (prescaler != queue->prescaler) {
+            spi_write_prescaler(instance, prescaler);
+            queue->prescaler = prescaler;
+        }
+        spi_write_comm(instance, tx, rx);
+        WRITE_FIELD(SPIx_CR2[instance], SPIx_CR2_TSIZE,
+                    (uint32_t)(job->size / (configs[instance].data_size / 8)));
+        WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_FTHVL, 0U); // One frame per DMA request
+
+        // RX finishing means every frame has been clocked. Without RX, the TX stream finishes
+        // when the last frame enters the FIFO, so the job also waits for the EOT interrupt.
+        queue->num_complete = 0;
+        queue->num_needed = rx ? (tx ? 2 : 1) : 2;
+        queue->active = true;
+        bool started = true;
+        if (rx) {
+            SET_FIELD(SPIx_CFG1[instance], SPIx_CFG1_RXDMAEN);
+            started = dma_start_transfer(&rx_transfer);
+        }
+        if (started && tx) {
+            started = dma_start_transfer(&tx_transfer);
+            if (!started && rx) {
+                // Drop the RX request, or it would hold up every later job on the stream.
+                dma_stream_abort(spi_to_dma[instance].rx_instance, spi_to_dma[instance].rx_stream);
+            }
+        }
+        if (!started) {
+            queue->active = false;
+            CLR_FIELD(SPIx_CFG1[instance], SPIx_CFG1_RXDMAEN);
+            WRITE_FIELD(SPIx_CR2[instance], SPIx_CR2_TSIZE, 0U);
+            SET_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+            spi_queue_entry_t failed = *entry;
+            queue->head = (queue->head + 1) % SPI_QUEUE_LEN;
+            queue->count--;
+            spi_finish_entry(&failed, false);
+            continue;
+        }
+        if (tx) {
+            SET_FIELD(SPIx_CFG1[instance], SPIx_CFG1_TXDMAEN);
+        }
+        if (!rx) {
+            SET_FIELD(SPIx_IER[instance], SPIx_IER_EOTIE);
+        }
+        SET_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+
+        // Select the device and start clocking
+        tal_set_pin(job->device.gpio_pin, 0);
+        SET_FIELD(SPIx_CR1[instance], SPIx_CR1_CSTART);
+    }
+}
+
+// Counts a completion event (DMA stream or EOT) for a queued job. A failure ends the job
+// straight away, and the other stream's transfer is aborted so it does not hold up the next
+// job's request on that stream. The next job is started before the callback runs, so the bus
+// does not sit idle behind it.
+static void spi_job_event(spi_queue_entry_t *entry, bool success) {
+    uint8_t instance = entry->job.device.instance;
+    spi_queue_t *queue = &spi_queues[instance];
+    if (!queue->active || entry != &queue->entries[queue->head]) {
+        return;
+    }
+    if (success && ++queue->num_complete < queue->num_needed) {
+        return;
+    }
+    if (!success) {
+        // The failed stream has already retired its transfer, so this only drops the sibling's.
+        if (entry->job.dest != NULL) {
+            dma_stream_abort(spi_to_dma[instance].rx_instance, spi_to_dma[instance].rx_stream);
+        }
+        if (entry->job.source != NULL) {
+            dma_stream_abort(spi_to_dma[instance].tx_instance, spi_to_dma[instance].tx_stream);
+        }
+    }
+    // A failed job never reaches EOT, so do not wait for it.
+    spi_end_transfer(instance, success ? SPI_EOT_TIMEOUT : 1);
+    tal_set_pin(entry->job.device.gpio_pin, 1);
+    spi_queue_entry_t done = *entry;
+    queue->head = (queue->head + 1) % SPI_QUEUE_LEN;
+    queue->count--;
+    queue->active = false;
+    spi_queue_start(instance);
+    spi_finish_entry(&done, success);
+}
+
+// Shared by the TX and RX streams
+static void spi_dma_callback(bool success, void *dma_context) {
+    spi_job_event((spi_queue_entry_t *)dma_context, success);
+}
+
+// Only EOT is enabled, and only for transmit-only jobs
+static void spi_irq_handler(uint8_t instance) {
+    if (!READ_FIELD(SPIx_IER[instance], SPIx_IER_EOTIE) ||
+        !READ_FIELD(SPIx_SR[instance], SPIx_SR_EOT)) {
+        return;
+    }
+    CLR_FIELD(SPIx_IER[instance], SPIx_IER_EOTIE);
+    spi_queue_t *queue = &spi_queues[instance];
+    spi_job_event(&queue->entries[queue->head], true);
+}
+
+static spi_context_t *spi_find_context(spi_device_t device) {
+    for (int i = 0; i < MAX_DEVICES_PER_INSTANCE; i++) {
+        if (spi_context_arr[device.instance][i].device.gpio_pin == device.gpio_pin) {
+            return &(spi_context_arr[device.instance][i]);
+        }
+    }
+    return NULL;
 }
 
 static bool check_device_valid(spi_device_t device) {
@@ -127,25 +456,28 @@ static bool check_device_valid(spi_device_t device) {
 /**************************************************************************************************
  * @section Public Function Implementations
  **************************************************************************************************/
-/**
- * @brief Initializes an SPI controller. Configures a TX and RX DMA stream for the SPI peripheral. 
- * It's important to choose SPI parameters that are compatible with all devices that will share the
- * controller.
- * 
- * @param flag Flag pointer for error heandling
- * @param spi_config Point to spi_config structure
- * @param tx_stream DMA configuration for TX stream
- * @param rx_stream DMA configuration for RX stream
- */
-int spi_init(uint8_t instance, spi_config_t *spi_config) {
+int spi_init(uint8_t instance, spi_config_t *spi_config, periph_dma_config_t *tx_stream,
+             periph_dma_config_t *rx_stream) {
     // Parameter checking
     if (instance > SPI_INSTANCE_COUNT)
         return TI_ERRC_INVALID_ARG;
     if (!check_spi_config_validity(spi_config))
         return TI_ERRC_INVALID_ARG;
+    if ((tx_stream == NULL) != (rx_stream == NULL))
+        return TI_ERRC_INVALID_ARG;
+    if (tx_stream != NULL && instance >= SPI_INSTANCE_COUNT)
+        return TI_ERRC_INVALID_ARG; // SPI6 is only served by the BDMA
+    
+    uint16_t prescaler = spi_config->baudrate_prescaler;
+    if (prescaler == 0) {
+        prescaler = spi_prescaler_for_sck(instance, spi_config->max_sck_hz);
+        if (prescaler == 0)
+            return TI_ERRC_INVALID_ARG;
+    }
     
     // Save the spi_config
     configs[instance] = *spi_config;
+    configs[instance].baudrate_prescaler = prescaler;
 
     // Enable gpio clocks for miso mosi and clk
     tal_enable_clock(spi_config->miso_pin);
@@ -198,52 +530,10 @@ int spi_init(uint8_t instance, spi_config_t *spi_config) {
     }
 
     // Configure SPI Mode
-    switch (spi_config->mode) {
-        case (0):
-            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
-            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
-            break;
-        case (1):
-            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
-            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
-            break;
-        case (2):
-            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
-            CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
-            break;
-        case (3):
-            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPOL);
-            SET_FIELD(SPIx_CFG2[instance], SPIx_CFG2_CPHA);
-            break;
-    }
+    spi_write_mode(instance, spi_config->mode);
 
     // Configure Baude Rate Prescaler
-    switch (spi_config->baudrate_prescaler) {
-        case (256):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b111);
-            break;
-        case (128):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b110);
-            break;
-        case (64):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b101);
-            break;
-        case (32):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b100);
-            break;
-        case (16):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b011);
-            break;
-        case (8):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b010);
-            break;
-        case (4):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b001);
-            break;
-        case (2):
-            WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_MBR, 0b000);
-            break;
-    }
+    spi_write_prescaler(instance, prescaler);
 
     // Set the Data Frame Format
     switch (spi_config->data_size) {
@@ -272,6 +562,52 @@ int spi_init(uint8_t instance, spi_config_t *spi_config) {
     CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_SSOE);
     CLR_FIELD(SPIx_CFG2[instance], SPIx_CFG2_SSM);
 
+    // Configure the DMA streams. Both sides move one frame per request, so the data sizes
+    // follow the frame size rather than the stream configs.
+    dma_periph_streaminfo_t info = {0};
+    if (tx_stream != NULL) {
+        dma_data_size_t frame_size = (spi_config->data_size == 16) ? DMA_DATA_SIZE_HALFWORD
+                                                                  : DMA_DATA_SIZE_BYTE;
+        dma_config_t dma_tx_stream = {
+            .instance = tx_stream->instance,
+            .stream = tx_stream->stream,
+            .request_id = spi_dmamux_req[instance][1],
+            .direction = MEM_TO_PERIPH,
+            .src_data_size = frame_size,
+            .dest_data_size = frame_size,
+            .priority = tx_stream->priority,
+            .fifo_enabled = tx_stream->fifo_enabled,
+            .fifo_threshold = tx_stream->fifo_threshold,
+            .callback = spi_dma_callback,
+        };
+        dma_config_t dma_rx_stream = {
+            .instance = rx_stream->instance,
+            .stream = rx_stream->stream,
+            .request_id = spi_dmamux_req[instance][0],
+            .direction = PERIPH_TO_MEM,
+            .src_data_size = frame_size,
+            .dest_data_size = frame_size,
+            .priority = rx_stream->priority,
+            .fifo_enabled = rx_stream->fifo_enabled,
+            .fifo_threshold = rx_stream->fifo_threshold,
+            .callback = spi_dma_callback,
+        };
+        if (!dma_configure_stream(&dma_tx_stream) || !dma_configure_stream(&dma_rx_stream))
+            return TI_ERRC_INVALID_ARG;
+        info.tx_instance = tx_stream->instance;
+        info.tx_stream = tx_stream->stream;
+        info.rx_instance = rx_stream->instance;
+        info.rx_stream = rx_stream->stream;
+    }
+    spi_to_dma[instance] = info;
+    if (tx_stream != NULL) {
+        int32_t irq = SPIx_IRQ_NUM[instance];
+        irq_set_priority(irq, SPI_IRQ_PRIORITY);
+        irq_enable(irq);
+    }
+    spi_queues[instance].mode = spi_config->mode;
+    spi_queues[instance].prescaler = prescaler;
+
     // Enable the SPI
     SET_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
 
@@ -318,129 +654,183 @@ bool spi_is_blocked(spi_device_t device) {
     // return (ti_is_mutex_locked(mutex[device.instance]) && !tal_read_pin(device.gpio_pin));
 }
 int spi_transfer_sync(struct spi_sync_transfer_t *transfer) {
+    if (transfer == NULL || transfer->size == 0 || transfer->timeout == 0)
+        return TI_ERRC_INVALID_ARG;
     spi_device_t device = transfer->device;
-    void *source = transfer->source;
+    uint8_t instance = device.instance;
+    if (instance == 0 || instance > SPI_INSTANCE_COUNT)
+        return TI_ERRC_INVALID_ARG;
+    const void *source = transfer->source;
     void *dest = transfer->dest;
-    size_t size = transfer->size;
-    uint32_t timeout = transfer->timeout;
     bool read_inc = transfer->read_inc;
-    bool write_inc = true; // assume TX increments
-    asm("BKPT #0");
-
-    // Optional: check SPI lock
-    // if (!spi_is_blocked(device)) {
-    //     return TI_ERRC_SPI_NOT_LOCKED;
-    // }
-
-    for (size_t i = 0; i < size; i++) {
-        uint32_t local_timeout = timeout;
-
-        // Wait until TX buffer has room
-        volatile uint32_t *SPI2_SR = (uint32_t *) 0x40003814;
-        uint32_t sr_debug = *SPI2_SR;
-        uint32_t sr_debug1 = *SPIx_SR[device.instance];
-        ro_reg32_t sr_debug2 = SPIx_SR[device.instance];
-        while (!READ_FIELD(SPIx_SR[device.instance], SPIx_SR_TXP)) {
-            if (--local_timeout == 0) {
-                return TI_ERRC_SPI_BLOCKING_TIMEOUT;
+    bool tx = (source != NULL);
+    bool rx = (dest != NULL);
+    if (!tx && !rx)
+        return TI_ERRC_INVALID_ARG;
+
+    // TSIZE counts frames, not bytes
+    size_t frame_bytes = configs[instance].data_size / 8;
+    if (frame_bytes == 0 || transfer->size % frame_bytes != 0 ||
+        transfer->size / frame_bytes > SPIx_CR2_TSIZE.msk)
+        return TI_ERRC_INVALID_ARG;
+    size_t frames = transfer->size / frame_bytes;
+
+    // Queued jobs own the bus until they have all run
+    if (spi_busy(instance)) {
+        return TI_ERRC_SPI_BUSY;
+    }
+
+    // A packet is one 32-bit TXDR/RXDR access, so TXP/RXP are only raised once a whole word
+    // fits or is waiting. TSIZE makes the controller stop by itself after the last frame, and
+    // lets the tail that does not fill a word be picked up through RXPLVL.
+    size_t packet = 4 / frame_bytes;
+    CLR_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+    WRITE_FIELD(SPIx_CR2[instance], SPIx_CR2_TSIZE, (uint32_t)frames);
+    WRITE_FIELD(SPIx_CFG1[instance], SPIx_CFG1_FTHVL, (uint32_t)(packet - 1));
+    spi_write_comm(instance, tx, rx);
+    SET_FIELD(SPIx_CR1[instance], SPIx_CR1_SPE);
+    SET_FIELD(SPIx_CR1[instance], SPIx_CR1_CSTART);
+
+    volatile uint8_t *txdr8 = (volatile uint8_t *)SPIx_TXDR[instance];
+    volatile uint16_t *txdr16 = (volatile uint16_t *)SPIx_TXDR[instance];
+    const volatile uint8_t *rxdr8 = (const volatile uint8_t *)SPIx_RXDR[instance];
+    const volatile uint16_t *rxdr16 = (const volatile uint16_t *)SPIx_RXDR[instance];
+    size_t tx_pos = 0;
+    size_t rx_pos = 0;
+    uint32_t idle = transfer->timeout;
+    while (rx ? (rx_pos < frames) : (tx_pos < frames)) {
+        uint32_t sr = *SPIx_SR[instance];
+        bool progress = false;
+
+        // Keep the TX FIFO primed a packet at a time, with a single frame for a short tail
+        if (tx && tx_pos < frames && (sr & SPIx_SR_TXP.msk) &&
+            (!rx || (tx_pos - rx_pos + packet) * frame_bytes <= SPI_SYNC_MAX_INFLIGHT)) {
+            if (frames - tx_pos >= packet) {
+                uint32_t word = 0;
+                for (size_t i = 0; i < packet; i++) {
+                    uint32_t frame = spi_frame_get(source, tx_pos + i, frame_bytes);
+                    word |= frame << (i * 8 * frame_bytes);
+                }
+                *SPIx_TXDR[instance] = word;
+                tx_pos += packet;
+            } else {
+                uint32_t frame = spi_frame_get(source, tx_pos, frame_bytes);
+                if (frame_bytes == 2) {
+                    *txdr16 = (uint16_t)frame;
+                } else {
+                    *txdr8 = (uint8_t)frame;
+                }
+                tx_pos++;
             }
+            progress = true;
         }
-        asm("BKPT #0");
-        // Write next byte
-        *SPIx_TXDR[device.instance] = ((uint8_t *)source)[i];
-
-        // Wait until RX buffer has data
-        local_timeout = timeout;
-        while (!READ_FIELD(SPIx_SR[device.instance], SPIx_SR_RXP)) {
-            if (--local_timeout == 0) {
-                return TI_ERRC_SPI_BLOCKING_TIMEOUT;
+
+        // Drain whole packets, then the tail frame by frame
+        if (!rx) {
+            // Transmit only, nothing comes back
+        } else if (frames - rx_pos >= packet) {
+            if (sr & SPIx_SR_RXP.msk) {
+                uint32_t word = *SPIx_RXDR[instance];
+                for (size_t i = 0; i < packet; i++) {
+                    spi_frame_put(dest, read_inc ? rx_pos : 0, frame_bytes, word);
+                    word >>= 8 * frame_bytes;
+                    rx_pos++;
+                }
+                progress = true;
             }
+        } else if ((sr & (SPIx_SR_RXPLVL.msk | SPIx_SR_RXWNE.msk)) != 0) {
+            uint32_t frame = (frame_bytes == 2) ? *rxdr16 : *rxdr8;
+            spi_frame_put(dest, read_inc ? rx_pos : 0, frame_bytes, frame);
+            rx_pos++;
+            progress = true;
         }
 
-        // Read received byte
-        size_t index = read_inc ? i : 0;
-        ((uint8_t *)dest)[index] = *SPIx_RXDR[device.instance];
+        if (progress) {
+            idle = transfer->timeout;
+        } else if (--idle == 0) {
+            spi_end_transfer(instance, 1);
+            return TI_ERRC_SPI_BLOCKING_TIMEOUT;
+        }
     }
 
-    // Optional: drain remaining RX data (if FIFO > 1)
-    while (READ_FIELD(SPIx_SR[device.instance], SPIx_SR_RXP)) {
-        (void)(*SPIx_RXDR[device.instance]);
-    }
+    // Transmit only transfers are done once the FIFO has emptied onto the bus
+    spi_end_transfer(instance, transfer->timeout);
+    return TI_ERRC_NONE;
+}
+
+static int spi_enqueue(const spi_job_t *job, spi_callback_t transfer_callback, bool src_inc,
+                       bool dest_inc) {
+    if (job->size == 0 || !check_device_valid(job->device))
+        return TI_ERRC_INVALID_ARG;
+    if (job->source == NULL && job->dest == NULL)
+        return TI_ERRC_INVALID_ARG;
+    if (job->mode != SPI_MODE_DEFAULT && job->mode > 3)
+        return TI_ERRC_INVALID_ARG;
+    uint16_t prescaler = job->baudrate_prescaler;
+    if (prescaler != 0 &&
+        (prescaler < 2 || prescaler > MAX_PRESCALER || (prescaler & (prescaler - 1))))
+        return TI_ERRC_INVALID_ARG;
+    uint8_t instance = job->device.instance;
+    if (spi_to_dma[instance].tx_instance == 0)
+        return TI_ERRC_SPI_NO_DMA;
 
+    // TSIZE counts frames, not bytes
+    size_t frame_bytes = configs[instance].data_size / 8;
+    if (job->size % frame_bytes != 0 || job->size / frame_bytes > SPIx_CR2_TSIZE.msk)
+        return TI_ERRC_INVALID_ARG;
+    if (spi_find_context(job->device) == NULL)
+        return TI_ERRC_SPI_NO_CONTEXT;
+
+    spi_queue_t *queue = &spi_queues[instance];
+    uint32_t primask = irq_save();
+    if (queue->count >= SPI_QUEUE_LEN) {
+        irq_restore(primask);
+        return TI_ERRC_SPI_QUEUE_FULL;
+    }
+    spi_queue_entry_t *entry = &queue->entries[(queue->head + queue->count) % SPI_QUEUE_LEN];
+    entry->job = *job;
+    entry->transfer_callback = transfer_callback;
+    entry->src_inc = src_inc;
+    entry->dest_inc = dest_inc;
+    queue->count++;
+    spi_queue_start(instance);
+    irq_restore(primask);
     return TI_ERRC_NONE;
 }
- int spi_transfer_async(struct spi_async_transfer_t *transfer) {
-    return 0;
- }
-//     spi_device_t device = transfer->device;
-//     void *source = transfer->source;
-//     void *dest = transfer->dest;
-//     size_t size = transfer->size;
-//     spi_callback_t callback = transfer->callback;
-//     bool write_fifo = transfer->write_fifo;
-//     bool read_fifo = transfer->read_fifo;
-//     bool write_mem_inc = transfer->write_mem_inc;
-//     bool read_mem_inc = transfer->read_mem_inc;
-
-//     // If spi transaction isn't locked, exit w/ error.
-//     if (!spi_is_blocked(device)) {
-//         return TI_ERRC_SPI_NOT_LOCKED;
-//     }
-
-//     // Get context
-//     spi_context_t *context = NULL;
-//     for (int i = 0; i < MAX_DEVICES_PER_INSTANCE; i++) {
-//         if (spi_context_arr[device.instance][i].device.instance == device.instance &&
-//             spi_context_arr[device.instance][i].device.gpio_pin == device.gpio_pin) {
-//             context = &(spi_context_arr[device.instance][i]);
-//         }
-//     }
-//     if (context == NULL)
-//         return TI_ERRC_SPI_NO_CONTEXT;
-//     context->callback = callback;
-    
-//     // TX Transfer
-//     dma_transfer_t tx_transfer = {
-//         .request_id = spi_dmamux_req[device.instance][1],
-//         .direction = MEM_TO_PERIPH,
-//         .src_data_size = configs[device.instance].data_size,
-//         .dest_data_size = configs[device.instance].data_size,
-//         .priority = configs[device.instance].priority,
-//         .callback = &spi_dma_callback,
-//         .fifo_enabled = !transfer->write_fifo,
-//         .src = source,
-//         .dest = SPIx_TXDR[device.instance],
-//         .size = size,
-//         .context = context,
-//         .mem_inc = write_mem_inc,
-//     };
-//     dma_start_transfer(&tx_transfer);
-
-//     // RX Transfer
-//     uint16_t dummy_buffer;
-//     dma_transfer_t rx_transfer = {
-//         .request_id = spi_dmamux_req[device.instance][0],
-//         .direction = PERIPH_TO_MEM,
-//         .src_data_size = configs[device.instance].data_size,
-//         .dest_data_size = configs[device.instance].data_size,
-//         .priority = configs[device.instance].priority,
-//         .callback = &spi_dma_callback,
-//         .fifo_enabled = false,
-//         .src = SPIx_RXDR[device.instance],
-//         .dest = &dummy_buffer,
-//         .size = size,
-//         .context = context,
-//         .mem_inc = read_mem_inc,
-//     };
-//     dma_start_transfer(&rx_transfer);
-
-//     // Enable DMA requests
-//     SET_FIELD(SPIx_CFG1[device.instance], SPIx_CFG1_RXDMAEN);
-//     SET_FIELD(SPIx_CFG1[device.instance], SPIx_CFG1_TXDMAEN);
 
+int spi_transfer_async(struct spi_async_transfer_t *transfer) {
+    if (transfer == NULL)
+        return TI_ERRC_INVALID_ARG;
+    spi_job_t job = {
+        .device = transfer->device,
+        .mode = SPI_MODE_DEFAULT,
+        .baudrate_prescaler = 0,
+        .source = transfer->source,
+        .dest = transfer->dest,
+        .size = transfer->size,
+        .callback = NULL,
+        .context = NULL,
+    };
+    return spi_enqueue(&job, transfer->callback, !transfer->fixed_source, !transfer->fixed_dest);
+}
 
-//     return TI_ERRC_NONE;
-//  }
+int spi_submit(const spi_job_t *job) {
+    if (job == NULL)
+        return TI_ERRC_INVALID_ARG;
+    return spi_enqueue(job, NULL, true, true);
+}
+
+bool spi_busy(uint8_t instance) {
+    if (instance > SPI_INSTANCE_COUNT)
+        return false;
+    return spi_queues[instance].count != 0;
+}
+
+void spi1_irq_handler(void) { spi_irq_handler(1); }
+void spi2_irq_handler(void) { spi_irq_handler(2); }
+void spi3_irq_handler(void) { spi_irq_handler(3); }
+void spi4_irq_handler(void) { spi_irq_handler(4); }
+void spi5_irq_handler(void) { spi_irq_handler(5); }
 
 // int spi_block(spi_device_t device) {
 //     // int errc = ti_acquire_mutex(mutex[device.instance], mutex_timeouts[device.instance]);
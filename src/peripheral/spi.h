@@ -29,6 +29,12 @@
 #define IS_VALID_DEVICE(device) ((device.instance > 0) && (device.instance < 7) && device.gpio_pin != 0)
 #define SPI_INSTANCE_COUNT 6
 
+// Jobs that can be waiting on each instance, including the one on the bus
+#define SPI_QUEUE_LEN 8
+
+// spi_job_t mode value that keeps the mode given to spi_init()
+#define SPI_MODE_DEFAULT 0xFF
+
 /**************************************************************************************************
  * @section Type definitions
  **************************************************************************************************/
@@ -50,7 +56,8 @@ typedef struct {
 typedef struct {
     uint8_t mode;     
     uint8_t data_size; 
-    uint16_t baudrate_prescaler; // Controls communication speed
+    uint16_t baudrate_prescaler; // 2-256, or 0 to derive it from max_sck_hz
+    uint32_t max_sck_hz; // SCK limit in Hz, checked against the live kernel clock
     uint8_t first_bit; // 0 for LSB 1 for MSB
     uint8_t clk_pin;
     uint8_t miso_pin;
@@ -61,34 +68,60 @@ typedef struct {
 
 typedef void (*spi_callback_t)(bool success);
 
-// Passed to DMA streams to un-init the SPI transfer
+// Device registered on an instance by spi_device_init()
 typedef struct {
     spi_device_t device;
-    uint8_t num_complete; // Number of DMA streams complete
-    spi_callback_t callback;
 } spi_context_t;
 
+typedef void (*spi_job_callback_t)(bool success, void *context);
+
+/**
+ * @brief A transaction queued with spi_submit().
+ *
+ * Devices on the same bus can run at different modes and speeds; the controller is only
+ * reconfigured when a job needs different settings from the one before it. Leaving out source
+ * or dest runs the controller in simplex mode, so only one DMA stream moves data.
+ *
+ * Buffers are used by DMA1/2, so they must not be in DTCM, and must stay valid until the
+ * callback is invoked.
+ */
+typedef struct {
+    spi_device_t device;
+    uint8_t mode;                // 0-3, or SPI_MODE_DEFAULT
+    uint16_t baudrate_prescaler; // 2-256, or 0 for the prescaler given to spi_init()
+    const void *source;          // NULL for a receive-only (simplex) transfer
+    void *dest;                  // NULL for a transmit-only (simplex) transfer
+    size_t size;                 // In bytes. A whole number of frames, at most 65535 frames.
+    spi_job_callback_t callback; // Called from the DMA interrupt once CS is released, or NULL
+    void *context;               // Passed to the callback
+} spi_job_t;
+
 struct spi_sync_transfer_t {
     // Useful for chaining multiple transfers together
     spi_device_t device;
-    void *source;
-    void *dest;
-    size_t size;
-    uint32_t timeout;
+    void *source;     // NULL for a receive-only transfer
+    void *dest;       // NULL for a transmit-only transfer
+    size_t size;      // In bytes. A whole number of frames, at most 65535 frames.
+    uint32_t timeout; // Status polls allowed without any frame moving
     bool read_inc; // If writing: set to false. Use uint8_t
 };
 
+/**
+ * @brief DMA transfer. Full duplex, or simplex (transmit-only or receive-only) when source or
+ * dest is NULL.
+ *
+ * Buffers are used by DMA1/2, so they must not be in DTCM (the stack lives there), and must
+ * stay valid until the callback is invoked.
+ */
 struct spi_async_transfer_t {
     // Useful for chaining multiple transfers together
     spi_device_t device;
-    void *source;
-    void *dest;
-    size_t size;
-    spi_callback_t callback;
-    bool write_fifo;
-    bool read_fifo;
-    bool write_mem_inc;
-    bool read_mem_inc;
+    void *source;   // NULL for a receive-only transfer
+    void *dest;     // NULL for a transmit-only transfer
+    size_t size;    // In bytes. Must be a whole number of frames, at most 65535 frames.
+    spi_callback_t callback; // Invoked from the DMA interrupt once CS has been released
+    bool fixed_source;  // Send the first frame of source repeatedly
+    bool fixed_dest;    // Receive every frame into the first frame of dest
 };
 
 /**************************************************************************************************
@@ -99,12 +132,15 @@ struct spi_async_transfer_t {
  * It's important to choose SPI parameters that are compatible with all devices that will share the
  * controller.
  * 
- * @param flag Flag pointer for error heandling
- * @param config Point to config structure
- * @param tx_stream DMA configuration for TX stream
+ * @param instance SPI instance (1-6)
+ * @param spi_config Point to config structure
+ * @param tx_stream DMA configuration for TX stream. NULL (along with rx_stream) if the instance
+ *                  is only used for blocking transfers. SPI6 has no DMA1/2 requests.
  * @param rx_stream DMA configuration for RX stream
+ * @return TI_ERRC_NONE on success, TI_ERRC_INVALID_ARG otherwise.
  */
-int spi_init(uint8_t instance, spi_config_t *spi_config);
+int spi_init(uint8_t instance, spi_config_t *spi_config, periph_dma_config_t *tx_stream,
+             periph_dma_config_t *rx_stream);
 
 /**
  * @brief Initialize an SPI Device. This sets up the CS line for the device
@@ -114,10 +150,47 @@ int spi_init(uint8_t instance, spi_config_t *spi_config);
  */
 int spi_device_init(spi_device_t device);
 
+/**
+ * @brief Runs a transfer, blocking until the last frame has been received, or sent for a
+ * transmit-only one. Full duplex, or simplex when source or dest is NULL. Moves the data with
+ * packed 32-bit FIFO accesses. CS is left to the caller.
+ *
+ * @param transfer Transfer description.
+ * @return TI_ERRC_NONE, TI_ERRC_SPI_BLOCKING_TIMEOUT, TI_ERRC_SPI_BUSY while async jobs are
+ *         queued, or TI_ERRC_INVALID_ARG.
+ */
 int spi_transfer_sync(struct spi_sync_transfer_t *transfer);
 
+/**
+ * @brief Queues a DMA transfer with a device, using the instance's mode and speed. Full duplex,
+ * or simplex when source or dest is NULL.
+ * Runs like a job given to spi_submit(): CS is asserted for the transfer and released once the
+ * transfer has completed, then the callback is invoked once with the combined result.
+ *
+ * @param transfer Transfer description. Only read during this call.
+ * @return See spi_submit().
+ */
 int spi_transfer_async(struct spi_async_transfer_t *transfer);
 
+/**
+ * @brief Queues a transaction on the device's instance.
+ * Jobs run back to back in submission order, each started from the completion interrupt of
+ * the one before, so devices sharing a bus need no locking of their own.
+ *
+ * @param job Job to queue. Copied, only the buffers must outlive the call.
+ * @return TI_ERRC_NONE if the job was queued, TI_ERRC_SPI_QUEUE_FULL if SPI_QUEUE_LEN jobs are
+ *         already waiting, TI_ERRC_SPI_NO_DMA if spi_init() was given no DMA streams,
+ *         TI_ERRC_SPI_NO_CONTEXT for an unregistered device or TI_ERRC_INVALID_ARG.
+ */
+int spi_submit(const spi_job_t *job);
+
+/**
+ * @brief Checks whether an instance has queued or running jobs.
+ * @param instance SPI instance
+ * @return true while jobs are waiting or on the bus.
+ */
+bool spi_busy(uint8_t instance);
+
 /**
  * @brief Block the spi device and instance from talking to anyone else.
  *        (Aquires the mutex and pulls the pin)
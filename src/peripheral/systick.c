@@ -20,18 +20,17 @@
  */
 
 #include <stdint.h>
+#include "internal/clock.h"
 #include "internal/mmio.h"
 #include "peripheral/errc.h"
 #include "peripheral/systick.h"
 
-// ((480 * 1,000,000) * 0.001 - 1)
-// 1ms countdown
-#define DEFAULT_RELOAD_VAL 0x752FF
-#define CLOCK_FREQ 480000000
+// Ticks per second
+#define SYSTICK_TICK_HZ 1000
 
 void systick_init() {
-    //Program reload value
-    WRITE_FIELD(STK_RVR, STK_RVR_RELOAD, DEFAULT_RELOAD_VAL);
+    //Program reload value for a 1ms countdown at the current core clock
+    WRITE_FIELD(STK_RVR, STK_RVR_RELOAD, clock_get_hz(CLOCK_CPU) / SYSTICK_TICK_HZ - 1);
 
     //Set clock source 
     SET_FIELD(STK_CSR, STK_CSR_CLKSOURCE);
@@ -25,6 +25,8 @@
 
 /**
  * @brief Initializes the systick timer. 
+ * 
+ * The reload value is worked out from the core clock, so call it again after clock_init().
  */
 void systick_init();
 
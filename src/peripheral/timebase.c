@@ -0,0 +1,114 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/peripheral/timebase.c
+ * @authors Charles Faisandier
+ * @brief Monotonic time since boot, from the DWT cycle counter and SysTick.
+ */
+
+#include <stdint.h>
+#include "internal/clock.h"
+#include "internal/interrupt.h"
+#include "internal/mmio.h"
+#include "internal/sections.h"
+#include "peripheral/systick.h"
+#include "peripheral/timebase.h"
+#include "util/swtimer.h"
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+
+#define TIME_US_PER_S 1000000U
+#define TIME_MS_PER_S 1000U
+
+// Bits of the 64 bit count taken from the cycle counter directly.
+#define TIME_LOW_BITS 31U
+#define TIME_LOW_MASK ((1U << TIME_LOW_BITS) - 1U)
+
+// Bits 31-62 of the 64 bit count as of the last tick. Bit 0 is the cycle counter's top bit at
+// that time, so a reader can tell whether the counter has since crossed into the next half.
+static TI_FAST_BSS volatile uint32_t time_epoch;
+
+// Core clock the cycles are converted with.
+static TI_FAST_BSS uint32_t time_cpu_hz;
+
+// Cycle count at time_init(). The cycles before it were counted at the reset clock, so the
+// time in seconds starts from here.
+static TI_FAST_BSS uint64_t time_start_cycles;
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+
+// Epoch of the current count. Stays valid for 2^31 cycles (~4.4 s at 480 MHz) after epoch was
+// read, as the count can only have moved into the next half of the counter's range.
+static inline uint32_t time_advance(uint32_t epoch, uint32_t cycles) {
+    return epoch + ((cycles >> TIME_LOW_BITS) ^ (epoch & 1U));
+}
+
+static uint64_t time_cycles_to(uint64_t cycles, uint32_t unit_hz) {
+    if (time_cpu_hz == 0) {
+        return 0;
+    }
+    // Split at whole seconds, so cycles * unit_hz cannot overflow.
+    uint64_t seconds = cycles / time_cpu_hz;
+    uint64_t rest = cycles % time_cpu_hz;
+    return seconds * unit_hz + rest * unit_hz / time_cpu_hz;
+}
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+
+void time_init(void) {
+    time_cpu_hz = clock_get_hz(CLOCK_CPU);
+    time_epoch = time_advance(time_epoch, *DWT_CYCCNT);
+    time_start_cycles = time_now_cycles();
+    systick_init();
+    // Lowest priority, so timer callbacks never hold up peripheral interrupts.
+    exc_set_priority(SYSTICK_EXC_NUM, (uint32_t)NVIC_MAX_PRIO - 1U);
+    SET_FIELD(STK_CSR, STK_CSR_TICKINT);
+}
+
+TI_FAST_CODE uint64_t time_now_cycles(void) {
+    // The epoch is read first, so it is never newer than the cycle count.
+    uint32_t epoch = time_epoch;
+    uint32_t cycles = *DWT_CYCCNT;
+    epoch = time_advance(epoch, cycles);
+    return ((uint64_t)epoch << TIME_LOW_BITS) | (cycles & TIME_LOW_MASK);
+}
+
+uint64_t time_now_us(void) {
+    return time_cycles_to(time_now_cycles() - time_start_cycles, TIME_US_PER_S);
+}
+
+uint64_t time_now_ms(void) {
+    return time_cycles_to(time_now_cycles() - time_start_cycles, TIME_MS_PER_S);
+}
+
+uint64_t time_cycles_to_us(uint64_t cycles) {
+    return time_cycles_to(cycles, TIME_US_PER_S);
+}
+
+/**************************************************************************************************
+ * @section Interrupt Handlers
+ **************************************************************************************************/
+
+TI_FAST_CODE void cm7_systick_exc_handler(void) {
+    time_epoch = time_advance(time_epoch, *DWT_CYCCNT);
+    swtimer_tick();
+}
@@ -0,0 +1,77 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/peripheral/timebase.h
+ * @authors Charles Faisandier
+ * @brief Monotonic time since boot, from the DWT cycle counter and SysTick.
+ *
+ * The DWT cycle counter runs at the core clock from reset, but is 32 bits wide and wraps every
+ * ~9 s at 480 MHz. The SysTick interrupt extends it to 64 bits: on each tick it records which
+ * half of the counter's range the count was in, in a single word. A reader combines that word
+ * with a fresh counter read, and can tell whether the counter wrapped since the tick. Nothing
+ * is ever retried or masked, so the time can be read from any thread or interrupt priority,
+ * including from inside the SysTick handler.
+ *
+ * The extension only needs the SysTick interrupt to run at least every ~4 s, so ticks that are
+ * late or cut short (systick_delay() restarts the count) do not affect the time.
+ *
+ * The cycle count starts at reset, but the cycles before clock_init() are counted at the reset
+ * clock, so times in seconds start at time_init() instead.
+ *
+ * The SysTick interrupt also advances the software timers (swtimer.h).
+ *
+ * The cycle counter is the CM7's, so this module is for the CM7 only.
+ */
+
+#pragma once
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+
+/**
+ * @brief Starts the SysTick interrupt that keeps the time, and starts time_now_us() and
+ *        time_now_ms() from zero. Call after clock_init(), since the cycle conversions use the
+ *        core clock frequency at the time of the call.
+ */
+void time_init(void);
+
+/**
+ * @brief Gets the number of core clock cycles since reset.
+ * @returns (uint64_t) The cycle count.
+ */
+uint64_t time_now_cycles(void);
+
+/**
+ * @brief Gets the time since time_init(), in microseconds.
+ * @returns (uint64_t) The time, or 0 before time_init().
+ */
+uint64_t time_now_us(void);
+
+/**
+ * @brief Gets the time since time_init(), in milliseconds.
+ * @returns (uint64_t) The time, or 0 before time_init().
+ */
+uint64_t time_now_ms(void);
+
+/**
+ * @brief Converts a number of core clock cycles, such as the difference of two
+ *        time_now_cycles() values, to microseconds.
+ * @param cycles (uint64_t) The cycle count.
+ * @returns (uint64_t) The duration in microseconds, rounded down.
+ */
+uint64_t time_cycles_to_us(uint64_t cycles);
@@ -20,6 +20,8 @@
  */
 
 #include "uart.h"
+#include "../internal/clock.h"
+#include "../internal/interrupt.h"
 #include "../internal/mmio.h"
 #include "gpio.h"
 #include <stdbool.h>
@@ -31,10 +33,48 @@
 #define CR_REG_COUNT 3
 #define NUM_REQUESTS_PER_UART 2
 
+// Depth of the hardware TX FIFO.
+#define UART_TX_FIFO_DEPTH 16
+
+// NVIC priority of the U(S)ART interrupts, below the DMA and SPI completions.
+#define UART_IRQ_PRIORITY 8U
+
+// Maximum number of status register polls a transmit wait may take.
+#define UART_TX_TIMEOUT 1000000000U
+
+// Register access and interrupt masking hooks for the transmit path. Host-side benchmarks
+// override these to run the path against a simulated peripheral.
+#ifndef UART_IRQ_SAVE
+#define UART_IRQ_SAVE() irq_save()
+#endif
+#ifndef UART_IRQ_RESTORE
+#define UART_IRQ_RESTORE(primask) irq_restore(primask)
+#endif
+#ifndef UART_REG_READ
+#define UART_REG_READ(reg) (*(reg))
+#endif
+#ifndef UART_REG_WRITE
+#define UART_REG_WRITE(reg, value) (*(reg) = (value))
+#endif
+
 #define IS_USART_CHANNEL(channel)                                              \
   ((channel) == UART1 || (channel) == UART2 || (channel) == UART3 ||           \
    (channel) == UART6)
 
+// Word offsets of the registers in a U(S)ART block. USART1/2/3/6 and UART4/5/7/8 share
+// the same layout, so every channel is addressed as base + offset.
+#define UART_REG_CR1 (0x00U / 4U)
+#define UART_REG_CR2 (0x04U / 4U)
+#define UART_REG_CR3 (0x08U / 4U)
+#define UART_REG_BRR (0x0CU / 4U)
+#define UART_REG_ISR (0x1CU / 4U)
+#define UART_REG_ICR (0x20U / 4U)
+#define UART_REG_RDR (0x24U / 4U)
+#define UART_REG_TDR (0x28U / 4U)
+#define UART_REG_PRESC (0x2CU / 4U)
+
+#define UART_REG(channel, reg) (uart_regs[(channel)].base + (reg))
+
 /**************************************************************************************************
  * @section  Data Structures
  **************************************************************************************************/
@@ -86,12 +126,79 @@ const static uint8_t uart_dmamux_req[UART_CHANNEL_COUNT]
 
 volatile dma_periph_streaminfo_t uart_to_dma[UART_CHANNEL_COUNT] = {0};
 
-bool uart_busy[UART_CHANNEL_COUNT] = {0};
+// Set while a uart_read_async() transfer is in flight. Writes are queued, so there is no
+// TX equivalent.
+bool uart_rx_busy[UART_CHANNEL_COUNT] = {0};
 
-uart_context_t uart_contexts[UART_CHANNEL_COUNT] = {0};
+// Contexts passed to the callback given to uart_init(). They only identify the channel and
+// direction, so one per direction is shared by all transfers on a channel.
+uart_context_t uart_tx_contexts[UART_CHANNEL_COUNT] = {0};
+uart_context_t uart_rx_contexts[UART_CHANNEL_COUNT] = {0};
 
 uint32_t timeout;
 
+// Interrupt-fed RX ring buffer. head is only written by the ISR and tail only by the
+// reader, both free-running, so no locking is needed with a single reader.
+typedef struct {
+  uint8_t *buffer;
+  uint32_t mask; // Buffer size - 1, the size is a power of two
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  volatile uint32_t dropped;
+  uart_rx_callback_t idle_callback;
+  void *context;
+} uart_rx_ring_t;
+
+static uart_rx_ring_t uart_rx_rings[UART_CHANNEL_COUNT] = {0};
+
+// Per-channel register block, resolved once by uart_init().
+typedef struct {
+  rw_reg32_t base;
+  int32_t irq;
+} uart_regs_t;
+
+static uart_regs_t uart_regs[UART_CHANNEL_COUNT] = {0};
+
+// Buffer handed over by uart_tx_submit().
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  uart_tx_release_t release;
+  void *context;
+} uart_tx_desc_t;
+
+// Zero-copy TX queue. Only modified from the channel's interrupt handlers, the TX DMA
+// callback, or with interrupts masked.
+typedef struct {
+  uart_tx_desc_t queue[UART_TX_QUEUE_LEN];
+  uint32_t head;
+  volatile uint32_t count;
+  size_t offset;    // Bytes of the head buffer already written to the FIFO
+  bool dma;         // Channel has a TX DMA stream
+  bool dma_active;  // Head buffer is being sent by the DMA
+} uart_tx_queue_t;
+
+static uart_tx_queue_t uart_tx_queues[UART_CHANNEL_COUNT] = {0};
+
+// Buffers taken off a TX queue, waiting for their release callbacks.
+typedef struct {
+  uart_tx_desc_t desc[UART_TX_QUEUE_LEN];
+  uint32_t count;
+} uart_tx_done_t;
+
+// Callback passed to uart_init(), invoked for buffers sent by uart_write_async() and
+// transfers started by uart_read_async().
+static dma_callback_t uart_dma_callbacks[UART_CHANNEL_COUNT] = {0};
+
+// Kernel clock dividers, indexed by PRESC register value.
+static const uint16_t uart_presc_div[] = {1, 2, 4, 6, 8, 10, 12, 16, 32, 64, 128, 256};
+
+// Baud rate generator settings applied by uart_init().
+static uart_baud_t uart_bauds[UART_CHANNEL_COUNT] = {0};
+
+// Kernel clock source selected by uart_init().
+static uart_clock_source_t uart_clock_sources[UART_CHANNEL_COUNT] = {0};
+
 /**************************************************************************************************
  * @section Private Function Implementations
  **************************************************************************************************/
@@ -402,82 +509,267 @@ bool set_alternate_function(uart_channel_t channel, uint8_t tx_pin,
       return false;
     }
     break;
+  case LPUART1:
+    if (tx_pin == 98) {
+      tal_alternate_mode(tx_pin, 3);
+    } else if (tx_pin == 133) {
+      tal_alternate_mode(tx_pin, 8);
+    } else {
+      // tal_raise(flag, "Invalid TX Pin for channel");
+      return false;
+    }
+    if (rx_pin == 99) {
+      tal_alternate_mode(rx_pin, 3);
+    } else if (rx_pin == 134) {
+      tal_alternate_mode(rx_pin, 8);
+    } else {
+      // tal_raise(flag, "Invalid RX Pin for channel");
+      return false;
+    }
+    break;
   default:
     return false;
   }
+  return true;
+}
+
+// Resolves the channel's register block and interrupt line. The USART, UART and LPUART
+// register layouts are identical (LPUART1 just lacks some bits), so this is the only place
+// the families are told apart.
+static void uart_resolve_regs(uart_channel_t channel) {
+  if (channel == LPUART1) {
+    uart_regs[channel].base = LPUART1_CR1;
+    uart_regs[channel].irq = LPUART_IRQ_NUM;
+  } else if (IS_USART_CHANNEL(channel)) {
+    uart_regs[channel].base = USARTx_CR1[channel];
+    uart_regs[channel].irq = USARTx_IRQ_NUM[channel];
+  } else {
+    uart_regs[channel].base = UARTx_CR1[channel];
+    uart_regs[channel].irq = UARTx_IRQ_NUM[channel];
+  }
 }
 
-bool uart_write_byte(uart_channel_t channel, uint8_t data) {
+// Pushes a buffer into the TX FIFO. With the FIFO enabled, TXE reads as TXFNF (FIFO not
+// full); when TXFE shows the FIFO empty, a full FIFO's worth is written without polling.
+// Returns once the last byte is queued, without waiting for it to be sent.
+static bool uart_tx_fill(uart_channel_t channel, const uint8_t *data, uint32_t size) {
+  ro_reg32_t isr = UART_REG(channel, UART_REG_ISR);
+  rw_reg32_t tdr = UART_REG(channel, UART_REG_TDR);
   uint32_t count = 0;
-  
-  if (IS_USART_CHANNEL(channel)) {
-    // Wait until the receive FIFO is not empty.
-    while (READ_FIELD(USARTx_ISR[channel], USARTx_ISR_TXE) == 0) {
-      if (count++ >= 1000000000) {
+  uint32_t i = 0;
+  while (i < size) {
+    uint32_t status = UART_REG_READ(isr);
+    uint32_t burst;
+    if (status & USARTx_ISR_TXFE.msk) {
+      burst = UART_TX_FIFO_DEPTH;
+    } else if (status & USARTx_ISR_TXE.msk) {
+      burst = 1;
+    } else {
+      if (count++ >= UART_TX_TIMEOUT) {
         return false; // Return false on timeout
       }
+      continue;
     }
-    WRITE_FIELD(USARTx_TDR[channel], USARTx_TDR_TDR, data);
-
-    // This is a blocking function, so we return immediately after the data is
-    // placed in the FIFO. If you needed to ensure the data was completely sent,
-    // you would wait for the TC (Transmission Complete) flag.
-    while (READ_FIELD(USARTx_ISR[channel], USARTx_ISR_TC) == 0) {
-      asm("nop");
+    if (burst > size - i) {
+      burst = size - i;
     }
-  } else {
-    while (READ_FIELD(UARTx_ISR[channel], UARTx_ISR_TXE) == 0) {
-      if (count++ >= 1000000000) {
-        return false; // Return false on timeout
-      }
+    while (burst--) {
+      UART_REG_WRITE(tdr, data[i++]);
     }
-     WRITE_FIELD(UARTx_TDR[channel], UARTx_TDR_TDR, data);
+  }
+  return true;
+}
 
-    // This is a blocking function, so we return immediately after the data is
-    // placed in the FIFO. If you needed to ensure the data was completely sent,
-    // you would wait for the TC (Transmission Complete) flag.
-    while (READ_FIELD(UARTx_ISR[channel], UARTx_ISR_TC) == 0) {
-      asm("nop");
+// Waits for the last queued byte to leave the shift register.
+static bool uart_tx_drain(uart_channel_t channel) {
+  ro_reg32_t isr = UART_REG(channel, UART_REG_ISR);
+  uint32_t count = 0;
+  while ((UART_REG_READ(isr) & USARTx_ISR_TC.msk) == 0U) {
+    if (count++ >= UART_TX_TIMEOUT) {
+      return false;
     }
   }
-
   return true;
 }
 
-bool uart_read_byte(uint8_t channel, uint8_t *data) {
-  uint32_t count = 0;
+bool uart_write_byte(uart_channel_t channel, uint8_t data) {
+  // This is a blocking function, so we return immediately after the data is
+  // placed in the FIFO. uart_write_blocking() waits for TC once per buffer.
+  return uart_tx_fill(channel, &data, 1);
+}
 
+bool uart_read_byte(uint8_t channel, uint8_t *data) {
   // Input validation: ensure the destination pointer is not NULL
   if (data == NULL) {
     return false;
   }
 
-  if (IS_USART_CHANNEL(channel)) {
-    // Wait until the receive FIFO is not empty.
-    while (READ_FIELD(USARTx_ISR[channel], USARTx_ISR_RXNE) == 0) {
-      asm("nop");
-    }
-    *data = (uint8_t)READ_FIELD(USARTx_RDR[channel], USARTx_RDR_RDR);
-    // while (READ_FIELD(USARTx_ISR[channel], USARTx_ISR_RXNE) == 0) {
-    //   asm("nop");
-    // }
-  } else {
-    while (READ_FIELD(UARTx_ISR[channel], UARTx_ISR_RXNE) == 0) {
-      asm("nop");
-    }
-    *data = (uint8_t)READ_FIELD(UARTx_RDR[channel], UARTx_RDR_RDR);
-    // while (READ_FIELD(UARTx_ISR[channel], UARTx_ISR_RXNE) == 0) {
-    //   asm("nop");
-    // }
+  // Wait until the receive FIFO is not empty.
+  while (READ_FIELD(UART_REG(channel, UART_REG_ISR), USARTx_ISR_RXNE) == 0) {
+    asm("nop");
   }
 
   // Read the data from the receive data register.
   // The hardware automatically retrieves the next available byte from the FIFO.
-  
-
+  *data = (uint8_t)READ_FIELD(UART_REG(channel, UART_REG_RDR), USARTx_RDR_RDR);
   return true;
 }
 
+// Drains the RX FIFO into the channel's ring buffer and reports idle-line frame boundaries.
+// Channels without a started ring are left alone, so the interrupt taken for the TX queue
+// does not steal bytes from uart_read_blocking() or uart_read_async().
+static void uart_rx_irq(uart_channel_t channel) {
+  uart_rx_ring_t *ring = &uart_rx_rings[channel];
+  if (ring->buffer == NULL ||
+      (IS_FIELD_CLR(UART_REG(channel, UART_REG_CR3), USARTx_CR3_RXFTIE) &&
+       IS_FIELD_CLR(UART_REG(channel, UART_REG_CR1), USARTx_CR1_IDLEIE))) {
+    return;
+  }
+  ro_reg32_t isr = UART_REG(channel, UART_REG_ISR);
+  ro_reg32_t rdr = UART_REG(channel, UART_REG_RDR);
+  rw_reg32_t icr = UART_REG(channel, UART_REG_ICR);
+
+  uint32_t head = ring->head;
+  while (IS_FIELD_SET(isr, USARTx_ISR_RXNE)) {
+    uint8_t data = (uint8_t)READ_FIELD(rdr, USARTx_RDR_RDR);
+    if (head - ring->tail > ring->mask) {
+      ring->dropped++;
+      continue;
+    }
+    ring->buffer[head & ring->mask] = data;
+    head++;
+  }
+  ring->head = head;
+
+  if (IS_FIELD_SET(isr, USARTx_ISR_ORE)) {
+    SET_WO_FIELD(icr, USARTx_ICR_ORECF);
+    ring->dropped++;
+  }
+  if (IS_FIELD_SET(isr, USARTx_ISR_IDLE)) {
+    SET_WO_FIELD(icr, USARTx_ICR_IDLECF);
+    if (ring->idle_callback != NULL) {
+      ring->idle_callback(channel, head - ring->tail, ring->context);
+    }
+  }
+}
+
+// Removes the head buffer from the TX queue and returns its descriptor.
+static uart_tx_desc_t uart_tx_pop(uart_tx_queue_t *tx) {
+  uart_tx_desc_t desc = tx->queue[tx->head];
+  tx->head = (tx->head + 1U) % UART_TX_QUEUE_LEN;
+  tx->offset = 0;
+  tx->count--;
+  return desc;
+}
+
+// Releases the buffers uart_tx_kick() sent through the FIFO, in queue order.
+static void uart_tx_release(uart_channel_t channel, const uart_tx_done_t *done) {
+  for (uint32_t i = 0; i < done->count; i++) {
+    if (done->desc[i].release != NULL) {
+      done->desc[i].release(channel, done->desc[i].data, true, done->desc[i].context);
+    }
+  }
+}
+
+// Sends as much of the TX queue as the hardware accepts right now. Large buffers are handed
+// to the DMA; short ones are written into the FIFO until it is full, and the FIFO threshold
+// interrupt is left enabled to continue once it drains. Buffers whose last byte is in the
+// FIFO are moved to @p done, for the caller to release once the channel's interrupt is
+// unmasked again. Called with interrupts masked, from the channel's interrupt, or from the TX
+// DMA callback. The DMA interrupt runs above the UART one, but it cannot fire inside a kick:
+// the stream only moves data once DMAT is set, and setting it is the last thing a kick does.
+static void uart_tx_kick(uart_channel_t channel, uart_tx_done_t *done) {
+  uart_tx_queue_t *tx = &uart_tx_queues[channel];
+  ro_reg32_t isr = UART_REG(channel, UART_REG_ISR);
+  rw_reg32_t tdr = UART_REG(channel, UART_REG_TDR);
+
+  while (tx->count > 0 && !tx->dma_active) {
+    uart_tx_desc_t *desc = &tx->queue[tx->head];
+
+    if (tx->dma && tx->offset == 0 && desc->size >= UART_TX_DMA_THRESHOLD) {
+      dma_transfer_t transfer = {
+          .instance = uart_to_dma[channel].tx_instance,
+          .stream = uart_to_dma[channel].tx_stream,
+          .src = desc->data,
+          .dest = (void *)tdr,
+          .size = desc->size,
+          .context = tx,
+          .disable_mem_inc = false,
+      };
+      if (dma_start_transfer(&transfer)) {
+        tx->dma_active = true;
+        CLR_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_TXFTIE);
+        SET_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_DMAT);
+        return;
+      }
+      // DMA stream queue is full, fall back to the FIFO.
+    }
+
+    while (tx->offset < desc->size && (UART_REG_READ(isr) & USARTx_ISR_TXE.msk)) {
+      UART_REG_WRITE(tdr, desc->data[tx->offset++]);
+    }
+    if (tx->offset < desc->size) {
+      SET_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_TXFTIE);
+      return;
+    }
+
+    done->desc[done->count++] = uart_tx_pop(tx);
+  }
+  if (tx->count == 0) {
+    CLR_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_TXFTIE);
+  }
+}
+
+// TX stream callback. The stream only carries the TX queue, so the transfer that completed
+// is always the queue's head buffer.
+static void uart_tx_dma_callback(bool success, void *context) {
+  uart_tx_queue_t *tx = (uart_tx_queue_t *)context;
+  uart_channel_t channel = (uart_channel_t)(tx - uart_tx_queues);
+  uart_tx_done_t done = {0};
+  tx->dma_active = false;
+  uart_tx_desc_t sent = uart_tx_pop(tx);
+  uart_tx_kick(channel, &done);
+  if (sent.release != NULL) {
+    sent.release(channel, sent.data, success, sent.context);
+  }
+  uart_tx_release(channel, &done);
+}
+
+// Release callback for buffers queued by uart_write_async(). Reports them to the callback
+// passed to uart_init().
+static void uart_write_async_release(uart_channel_t channel, const uint8_t *buffer,
+                                     bool success, void *context) {
+  (void)buffer;
+  if (uart_dma_callbacks[channel] != NULL) {
+    uart_dma_callbacks[channel](success, context);
+  }
+}
+
+// RX stream callback. Frees the channel for the next uart_read_async() before reporting the
+// transfer to the callback passed to uart_init().
+static void uart_rx_dma_callback(bool success, void *context) {
+  uart_context_t *uart_context = (uart_context_t *)context;
+  uart_rx_busy[uart_context->channel] = false;
+  if (uart_dma_callbacks[uart_context->channel] != NULL) {
+    uart_dma_callbacks[uart_context->channel](success, context);
+  }
+}
+
+// Common interrupt entry point for all channels.
+static void uart_irq_handler(uart_channel_t channel) {
+  // The wakeup flag only needs clearing, the received data is picked up below.
+  if (IS_FIELD_SET(UART_REG(channel, UART_REG_ISR), USARTx_ISR_WUF)) {
+    SET_WO_FIELD(UART_REG(channel, UART_REG_ICR), USARTx_ICR_WUCF);
+  }
+  uart_rx_irq(channel);
+  if (IS_FIELD_SET(UART_REG(channel, UART_REG_CR3), USARTx_CR3_TXFTIE) &&
+      IS_FIELD_SET(UART_REG(channel, UART_REG_ISR), USARTx_ISR_TXFT)) {
+    uart_tx_done_t done = {0};
+    uart_tx_kick(channel, &done);
+    uart_tx_release(channel, &done);
+  }
+}
+
 static inline bool verify_transfer_parameters(uart_channel_t channel, uint8_t *buff,
                                        size_t size) {
 
@@ -495,6 +787,48 @@ static inline bool verify_transfer_parameters(uart_channel_t channel, uint8_t *b
   return true;
 }
 
+// Kernel clock selections in the RCC, each shared by the channels mapped to it.
+typedef enum {
+  UART_CLOCK_MUX_USART16,
+  UART_CLOCK_MUX_USART234578,
+  UART_CLOCK_MUX_LPUART1,
+} uart_clock_mux_t;
+
+static uart_clock_mux_t uart_clock_mux(uart_channel_t channel) {
+  if (channel == LPUART1) {
+    return UART_CLOCK_MUX_LPUART1;
+  }
+  if (channel == UART1 || channel == UART6) {
+    return UART_CLOCK_MUX_USART16;
+  }
+  return UART_CLOCK_MUX_USART234578;
+}
+
+// Frequency of a channel's kernel clock, read from the RCC. The PCLK source is the APB bus the
+// channel sits on.
+static uint32_t uart_kernel_clock_hz(uart_channel_t channel, uart_clock_source_t source) {
+  switch (source) {
+    case UART_CLOCK_PCLK:
+      if (channel == LPUART1) {
+        return clock_get_hz(CLOCK_PCLK4);
+      }
+      return (channel == UART1 || channel == UART6) ? clock_get_hz(CLOCK_PCLK2)
+                                                    : clock_get_hz(CLOCK_PCLK1);
+    case UART_CLOCK_PLL2Q:
+      return clock_get_hz(CLOCK_PLL2_Q);
+    case UART_CLOCK_PLL3Q:
+      return clock_get_hz(CLOCK_PLL3_Q);
+    case UART_CLOCK_HSI:
+      return clock_get_hz(CLOCK_HSI);
+    case UART_CLOCK_CSI:
+      return clock_get_hz(CLOCK_CSI);
+    case UART_CLOCK_LSE:
+      return clock_get_hz(CLOCK_LSE);
+    default:
+      return 0U;
+  }
+}
+
 /**
  * Macro that generates cases for uart init
  * @author Owen Voskuhl Hayes, Lorde of the Isle, first of his name.
@@ -512,6 +846,94 @@ static inline bool verify_transfer_parameters(uart_channel_t channel, uint8_t *b
 /**************************************************************************************************
  * @section Public Function Implementations
  **************************************************************************************************/
+bool uart_baud_solve(uint32_t clk_freq, uint32_t baud_rate, uart_baud_t *result) {
+  if (result == NULL || baud_rate == 0 || clk_freq / 8U < baud_rate) {
+    return false;
+  }
+
+  // Best error so far, as the fraction best_error / best_scale of the requested rate.
+  uint64_t best_error = 0;
+  uint64_t best_scale = 0;
+  for (uint32_t over8 = 0; over8 <= 1; over8++) {
+    // Baud = clk_freq * (over8 ? 2 : 1) / (prescaler * USARTDIV), and USARTDIV must be in
+    // 16..0xFFFF in both modes. With 8x oversampling BRR has no room for USARTDIV[0], so
+    // only even dividers can be programmed.
+    uint64_t numerator = (uint64_t)clk_freq * (over8 ? 2U : 1U);
+    uint64_t step = over8 ? 2U : 1U;
+    for (uint32_t presc = 0; presc < sizeof(uart_presc_div) / sizeof(uart_presc_div[0]);
+         presc++) {
+      uint64_t denominator = (uint64_t)uart_presc_div[presc] * baud_rate;
+      uint64_t div = ((numerator + denominator * step / 2U) / (denominator * step)) * step;
+      if (div < 16U || div > 0xFFFFU) {
+        continue;
+      }
+      uint64_t scale = denominator * div;
+      uint64_t error = (numerator > scale) ? numerator - scale : scale - numerator;
+      if (best_scale != 0 && error * best_scale >= best_error * scale) {
+        continue;
+      }
+      best_error = error;
+      best_scale = scale;
+
+      uint64_t divider = (uint64_t)uart_presc_div[presc] * div;
+      result->presc = presc;
+      result->over8 = (over8 != 0);
+      // With 8x oversampling BRR[3] must be 0 and BRR[2:0] holds USARTDIV[3:1].
+      result->brr = over8 ? (((uint32_t)div & 0xFFF0U) | (((uint32_t)div & 0xFU) >> 1))
+                          : (uint32_t)div;
+      result->actual_baud = (uint32_t)((numerator + divider / 2U) / divider);
+      result->error_ppm =
+          (int32_t)((((int64_t)numerator - (int64_t)scale) * 1000000) / (int64_t)scale);
+    }
+  }
+  return best_scale != 0;
+}
+
+// LPUART1 variant of uart_baud_solve(). Baud = 256 * ker_ck_pres / BRR, where BRR is 20 bits
+// wide and at least 0x300, and there is no oversampling mode to choose.
+static bool uart_lpuart_baud_solve(uint32_t clk_freq, uint32_t baud_rate, uart_baud_t *result) {
+  if (result == NULL || baud_rate == 0) {
+    return false;
+  }
+
+  uint64_t best_error = 0;
+  uint64_t best_scale = 0;
+  uint64_t numerator = (uint64_t)clk_freq * 256U;
+  for (uint32_t presc = 0; presc < sizeof(uart_presc_div) / sizeof(uart_presc_div[0]);
+       presc++) {
+    uint64_t denominator = (uint64_t)uart_presc_div[presc] * baud_rate;
+    uint64_t brr = (numerator + denominator / 2U) / denominator;
+    if (brr < 0x300U || brr > 0xFFFFFU) {
+      continue;
+    }
+    uint64_t scale = denominator * brr;
+    uint64_t error = (numerator > scale) ? numerator - scale : scale - numerator;
+    if (best_scale != 0 && error * best_scale >= best_error * scale) {
+      continue;
+    }
+    best_error = error;
+    best_scale = scale;
+
+    uint64_t divider = (uint64_t)uart_presc_div[presc] * brr;
+    result->presc = presc;
+    result->over8 = false;
+    result->brr = (uint32_t)brr;
+    result->actual_baud = (uint32_t)((numerator + divider / 2U) / divider);
+    result->error_ppm =
+        (int32_t)((((int64_t)numerator - (int64_t)scale) * 1000000) / (int64_t)scale);
+  }
+  return best_scale != 0;
+}
+
+bool uart_get_baud(uart_channel_t channel, uart_baud_t *result) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT || result == NULL ||
+      uart_bauds[channel].actual_baud == 0) {
+    return false;
+  }
+  *result = uart_bauds[channel];
+  return true;
+}
+
 bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
                periph_dma_config_t *tx_stream, periph_dma_config_t *rx_stream) {
   // De-reference struct members for readability
@@ -522,7 +944,6 @@ bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
   uint8_t rx_pin;
   uint8_t ck_pin = 0;
   uint32_t baud_rate = usart_config->baud_rate;
-  // TODO: I think to get exact numbers for this I need devboard
   uint32_t clk_freq = usart_config->clk_freq;
   
   // Enable usart clock
@@ -563,6 +984,10 @@ bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
       tx_pin = 139;
       rx_pin = 138;
       break;
+    case LPUART1:
+      tx_pin = 98;
+      rx_pin = 99;
+      break;
     default:
       return false;
       break;
@@ -576,6 +1001,7 @@ bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
     UART_FIELD_GENERATOR(UART6, 5, RCC_APB2ENR)
     UART_FIELD_GENERATOR(UART7, 30, RCC_APB1LENR)
     UART_FIELD_GENERATOR(UART8, 31, RCC_APB1LENR)
+    UART_FIELD_GENERATOR(LPUART1, 3, RCC_APB4ENR)
   default:
     // Handle error or invalid USART number
     return false;
@@ -599,80 +1025,87 @@ bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
     return false;
   }
 
+  // LPUART1 is only reachable from the BDMA, which is not supported.
+  if (channel == LPUART1 && (tx_stream != NULL || rx_stream != NULL)) {
+    // tal_raise(flag, "LPUART1 does not support DMA");
+    return false;
+  }
+
+  uart_resolve_regs(channel);
+  rw_reg32_t cr1 = UART_REG(channel, UART_REG_CR1);
 
   // Ensure the clock pin is disabled for asynchronous mode
   // TODO: check on this
-  if (!IS_USART_CHANNEL(channel)) {
-    CLR_FIELD(UARTx_CR2[channel], UARTx_CR2_CLKEN);
+  if (channel != LPUART1) {
+    CLR_FIELD(UART_REG(channel, UART_REG_CR2), USARTx_CR2_CLKEN);
   }
 
-  // TODO: maybe calculate via using ints for mantissa/exponent field?
-  uint32_t brr_value = clk_freq / baud_rate;
-  if (IS_USART_CHANNEL(channel)) {
-  WRITE_FIELD(USARTx_BRR[channel], USARTx_BRR_BRR_4_15, brr_value);
-
-  // Set parity
-  switch (parity) {
-    case UART_PARITY_DISABLED:
-      CLR_FIELD(USARTx_CR1[channel], USARTx_CR1_PCE);
-      break;
-    case UART_PARITY_EVEN:
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_PCE);
-      CLR_FIELD(USARTx_CR1[channel], USARTx_CR1_PS);
-      break;
-    case UART_PARITY_ODD:
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_PCE);
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_PS);
-      break;
+  // The kernel clock selection is shared with the sibling channels, whose baud rates were
+  // computed for the source they were initialized with.
+  for (uint32_t other = 1; other < UART_CHANNEL_COUNT; other++) {
+    if (other != channel && uart_regs[other].base != NULL &&
+        uart_clock_mux(other) == uart_clock_mux(channel) &&
+        uart_clock_sources[other] != usart_config->clk_source) {
+      // tal_raise(flag, "Kernel clock source conflicts with an initialized channel");
+      return false;
+    }
   }
 
-
-  // Set data length
-  switch (data_length) {
-    case UART_DATALENGTH_7:
-      if (!parity) {
-        // tal_raise(flag, "Invalid parity datasize combo");
-        return false;
-      }
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[0]);
-      CLR_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[1]);
+  // Select the kernel clock and program the baud rate generator. The prescaler, oversampling
+  // mode and BRR can only be changed while the USART is disabled.
+  CLR_FIELD(cr1, USARTx_CR1_UE);
+  switch (uart_clock_mux(channel)) {
+    case UART_CLOCK_MUX_LPUART1:
+      WRITE_FIELD(RCC_D3CCIPR, RCC_D3CCIPR_LPUART1SRC, usart_config->clk_source);
       break;
-    case UART_DATALENGTH_8:
-      CLR_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[0]);
-      CLR_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[1]);
+    case UART_CLOCK_MUX_USART16:
+      WRITE_FIELD(RCC_D2CCIP2R, RCC_D2CCIP2R_USART16SRC, usart_config->clk_source);
       break;
-    case UART_DATALENGTH_9:
-      if (parity) {
-        // tal_raise(flag, "Invalid parity datasize combo");
-        return false;
-      }
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[0]);
-      SET_FIELD(USARTx_CR1[channel], USARTx_CR1_Mx[1]);
+    default:
+      WRITE_FIELD(RCC_D2CCIP2R, RCC_D2CCIP2R_USART234578SRC, usart_config->clk_source);
       break;
   }
-  
-
-  // Enable FIFOs
-  SET_FIELD(USARTx_CR1[channel], USARTx_CR1_FIFOEN);
-} else {
-  WRITE_FIELD(UARTx_BRR[channel], UARTx_BRR_BRR_4_15, brr_value);
+  uart_clock_sources[channel] = usart_config->clk_source;
+  if (clk_freq == 0) {
+    clk_freq = uart_kernel_clock_hz(channel, usart_config->clk_source);
+  }
+  uart_baud_t baud;
+  bool solved = (channel == LPUART1) ? uart_lpuart_baud_solve(clk_freq, baud_rate, &baud)
+                                     : uart_baud_solve(clk_freq, baud_rate, &baud);
+  if (!solved ||
+      baud.error_ppm > UART_BAUD_MAX_ERROR_PPM || baud.error_ppm < -UART_BAUD_MAX_ERROR_PPM) {
+    // tal_raise(flag, "Baud rate cannot be generated from the kernel clock");
+    return false;
+  }
+  WRITE_FIELD(UART_REG(channel, UART_REG_PRESC), USARTx_PRESC_PRESCALER, baud.presc);
+  if (channel == LPUART1) {
+    WRITE_FIELD(UART_REG(channel, UART_REG_BRR), LPUART1_BRR_BRR, baud.brr);
+  } else {
+    if (baud.over8) {
+      SET_FIELD(cr1, USARTx_CR1_OVER8);
+    } else {
+      CLR_FIELD(cr1, USARTx_CR1_OVER8);
+    }
+    WRITE_FIELD(UART_REG(channel, UART_REG_BRR), USARTx_BRR_BRR_4_15, baud.brr >> 4);
+    WRITE_FIELD(UART_REG(channel, UART_REG_BRR), USARTx_BRR_BRR_0_3, baud.brr & 0xFU);
+  }
+  uart_bauds[channel] = baud;
 
   // Set parity
   switch (parity) {
     case UART_PARITY_DISABLED:
-      CLR_FIELD(UARTx_CR1[channel], UARTx_CR1_PCE);
+      CLR_FIELD(cr1, USARTx_CR1_PCE);
       break;
     case UART_PARITY_EVEN:
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_PCE);
-      CLR_FIELD(UARTx_CR1[channel], UARTx_CR1_PS);
+      SET_FIELD(cr1, USARTx_CR1_PCE);
+      CLR_FIELD(cr1, USARTx_CR1_PS);
       break;
     case UART_PARITY_ODD:
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_PCE);
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_PS);
+      SET_FIELD(cr1, USARTx_CR1_PCE);
+      SET_FIELD(cr1, USARTx_CR1_PS);
       break;
   }
 
-
   // Set data length
   switch (data_length) {
     case UART_DATALENGTH_7:
@@ -680,76 +1113,85 @@ bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
         // tal_raise(flag, "Invalid parity datasize combo");
         return false;
       }
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[0]);
-      CLR_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[1]);
+      SET_FIELD(cr1, USARTx_CR1_Mx[0]);
+      CLR_FIELD(cr1, USARTx_CR1_Mx[1]);
       break;
     case UART_DATALENGTH_8:
-      CLR_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[0]);
-      CLR_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[1]);
+      CLR_FIELD(cr1, USARTx_CR1_Mx[0]);
+      CLR_FIELD(cr1, USARTx_CR1_Mx[1]);
       break;
     case UART_DATALENGTH_9:
       if (parity) {
         // tal_raise(flag, "Invalid parity datasize combo");
         return false;
       }
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[0]);
-      SET_FIELD(UARTx_CR1[channel], UARTx_CR1_Mx[1]);
+      SET_FIELD(cr1, USARTx_CR1_Mx[0]);
+      SET_FIELD(cr1, USARTx_CR1_Mx[1]);
       break;
   }
-  
-
-  // Enable FIFOs
-  SET_FIELD(UARTx_CR1[channel], UARTx_CR1_FIFOEN);
-  
-}
 
-  dma_config_t dma_tx_stream = {
-      .instance = tx_stream->instance,
-      .stream = tx_stream->stream,
-      .request_id = uart_dmamux_req[channel][1],
-      .direction = tx_stream->direction,
-      .src_data_size = tx_stream->src_data_size,
-      .dest_data_size = tx_stream->dest_data_size,
-      .priority = tx_stream->priority,
-      .fifo_enabled = false, // FIFO disabled for tx
-      .fifo_threshold = tx_stream->fifo_threshold,
-      .callback = *callback, // We need to know if it failed.
-  };
-  dma_configure_stream(&dma_tx_stream);
-
-  dma_config_t dma_rx_stream = {
-      .instance = rx_stream->instance,
-      .stream = rx_stream->stream,
-      .request_id = uart_dmamux_req[channel][0],
-      .direction = rx_stream->direction,
-      .src_data_size = rx_stream->src_data_size,
-      .dest_data_size = rx_stream->dest_data_size,
-      .priority = rx_stream->priority,
-      .fifo_enabled = false, // FIFO disabled for tx
-      .fifo_threshold = rx_stream->fifo_threshold,
-      .callback = *callback, // We need to know if it failed.
-  };
-  dma_configure_stream(&dma_rx_stream);
+  // Enable FIFOs. The TX FIFO threshold interrupt, used by the TX queue, fires once the
+  // FIFO has drained to half full.
+  SET_FIELD(cr1, USARTx_CR1_FIFOEN);
+  WRITE_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_TXFTCFG, 2U);
+
+  // DMA streams are optional; channels used only for blocking or interrupt-driven
+  // transfers pass NULL.
+  uart_dma_callbacks[channel] = (callback != NULL) ? *callback : NULL;
+  uart_tx_contexts[channel] = (uart_context_t){.busy = NULL, .channel = channel};
+  uart_rx_contexts[channel] = (uart_context_t){.busy = &uart_rx_busy[channel], .channel = channel};
+  dma_periph_streaminfo_t info = {0};
+  if (tx_stream != NULL) {
+    dma_config_t dma_tx_stream = {
+        .instance = tx_stream->instance,
+        .stream = tx_stream->stream,
+        .request_id = uart_dmamux_req[channel][1],
+        .direction = tx_stream->direction,
+        .src_data_size = tx_stream->src_data_size,
+        .dest_data_size = tx_stream->dest_data_size,
+        .priority = tx_stream->priority,
+        .fifo_enabled = false, // FIFO disabled for tx
+        .fifo_threshold = tx_stream->fifo_threshold,
+        .bufferable = true,
+        .callback = uart_tx_dma_callback, // Only used by the TX queue
+    };
+    dma_configure_stream(&dma_tx_stream);
+    info.tx_instance = tx_stream->instance;
+    info.tx_stream = tx_stream->stream;
+  }
+  uart_tx_queues[channel].dma = (tx_stream != NULL);
+
+  if (rx_stream != NULL) {
+    dma_config_t dma_rx_stream = {
+        .instance = rx_stream->instance,
+        .stream = rx_stream->stream,
+        .request_id = uart_dmamux_req[channel][0],
+        .direction = rx_stream->direction,
+        .src_data_size = rx_stream->src_data_size,
+        .dest_data_size = rx_stream->dest_data_size,
+        .priority = rx_stream->priority,
+        .fifo_enabled = false, // FIFO disabled for tx
+        .fifo_threshold = rx_stream->fifo_threshold,
+        .bufferable = true,
+        .callback = uart_rx_dma_callback, // We need to know if it failed.
+    };
+    dma_configure_stream(&dma_rx_stream);
+    info.rx_instance = rx_stream->instance;
+    info.rx_stream = rx_stream->stream;
+  }
 
   // Save stream info
-  dma_periph_streaminfo_t info = {.rx_instance = rx_stream->instance,
-                                  .tx_instance = tx_stream->instance,
-                                  .rx_stream = rx_stream->stream,
-                                  .tx_stream = tx_stream->stream};
   uart_to_dma[channel] = info;
 
   // Enable the peripheral
-
-  if (IS_USART_CHANNEL(channel)) {
-    SET_FIELD(USARTx_CR1[channel], USARTx_CR1_TE);
-    SET_FIELD(USARTx_CR1[channel], USARTx_CR1_RE);
-    SET_FIELD(USARTx_CR1[channel], USARTx_CR1_UE);
-  } else {
-     SET_FIELD(UARTx_CR1[channel], UARTx_CR1_TE);
-    SET_FIELD(UARTx_CR1[channel], UARTx_CR1_RE);
-    SET_FIELD(UARTx_CR1[channel], UARTx_CR1_UE);
-  }
-
+  SET_FIELD(cr1, USARTx_CR1_TE);
+  SET_FIELD(cr1, USARTx_CR1_RE);
+  SET_FIELD(cr1, USARTx_CR1_UE);
+
+  // The interrupt line is left enabled; the TX queue, RX ring and Stop mode wakeup each turn
+  // on their own interrupt sources.
+  irq_set_priority(uart_regs[channel].irq, UART_IRQ_PRIORITY);
+  irq_enable(uart_regs[channel].irq);
   return true;
 }
 
@@ -760,33 +1202,13 @@ bool uart_write_async(uart_channel_t channel, uint8_t *tx_buff, uint32_t size) {
     return false;
   }
 
-  // Check if usart channel is busy
-  if (uart_busy[channel]) {
-    // tal_raise(flag, "USART channel is busy");
+  // Goes through the TX queue, so it is sent in order with buffers from uart_tx_submit()
+  // instead of racing them on the TX stream.
+  if (!uart_tx_submit(channel, tx_buff, size, uart_write_async_release,
+                      &uart_tx_contexts[channel])) {
+    // tal_raise(flag, "USART TX queue is full");
     return false;
   }
-  uart_busy[channel] = true;
-
-  // Configure DMA stream
-  uart_context_t context = {
-      .busy = &uart_busy[channel],
-      .channel = channel,
-  };
-  uart_contexts[channel] = context;
-  dma_transfer_t tx_transfer = {
-      .instance = uart_to_dma[channel].tx_instance,
-      .stream = uart_to_dma[channel].tx_stream,
-      .src = tx_buff,
-      .dest = (void *)UARTx_TDR[channel], // maybe revisit the cast... in dma transfer struct
-      .size = size,
-      .context = &uart_contexts[channel],
-      .disable_mem_inc = false,
-  };
-  dma_start_transfer(&tx_transfer);
-
-  // Enable the dma requests
-  SET_FIELD(UARTx_CR3[channel], UARTx_CR3_DMAT);
-
   return true;
 }
 
@@ -797,32 +1219,30 @@ bool uart_read_async(uart_channel_t channel, uint8_t *rx_buff, uint32_t size) {
     return false;
   }
 
-  // Check if usart channel is busy
-  if (uart_busy[channel]) {
+  // Check if a read is already in flight on the channel
+  if (uart_rx_busy[channel]) {
     // tal_raise(flag, "USART channel is busy");
     return false;
   }
-  uart_busy[channel] = true;
+  uart_rx_busy[channel] = true;
 
   // Configure DMA stream
-  uart_context_t context = {
-      .busy = &uart_busy[channel],
-      .channel = channel,
-  };
-  uart_contexts[channel] = context;
-  dma_transfer_t tx_transfer = {
-      .instance = uart_to_dma[channel].tx_instance,
-      .stream = uart_to_dma[channel].tx_stream,
-      .src = (void *) UARTx_RDR[channel],
+  dma_transfer_t rx_transfer = {
+      .instance = uart_to_dma[channel].rx_instance,
+      .stream = uart_to_dma[channel].rx_stream,
+      .src = (void *)UART_REG(channel, UART_REG_RDR),
       .dest = rx_buff,
       .size = size,
-      .context = &uart_contexts[channel],
+      .context = &uart_rx_contexts[channel],
       .disable_mem_inc = false,
   };
-  dma_start_transfer(&tx_transfer);
+  if (!dma_start_transfer(&rx_transfer)) {
+    uart_rx_busy[channel] = false;
+    return false;
+  }
 
   // Enable the dma requests
-  SET_FIELD(UARTx_CR3[channel], UARTx_CR3_DMAT);
+  SET_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_DMAR);
   return true;
 }
 
@@ -835,23 +1255,12 @@ bool uart_write_blocking(uart_channel_t channel, uint8_t *tx_buff,
     return false;
   }
 
-  // Check if usart channel is busy
-  // while (!READ_FIELD(USARTx_ISR[channel], USARTx_ISR_BUSY)) {
-  //   asm("nop");
-  //   // tal_raise(flag, "USART channel is busy");
-  // }
-  // uart_busy[channel] = true;
-
-  // Transmit the data byte by byte
-  for (uint32_t i = 0; i < size; i++) {
-    if (!uart_write_byte(channel, tx_buff[i])) {
-      // tal_raise(flag, "USART write timeout");
-      // uart_busy[channel] = false;
-      return false;
-    }
+  // Keep the FIFO topped up so the line runs back to back, then wait for the
+  // transmission to complete once at the end.
+  if (!uart_tx_fill(channel, tx_buff, size) || !uart_tx_drain(channel)) {
+    // tal_raise(flag, "USART write timeout");
+    return false;
   }
-
-  // uart_busy[channel] = false;
   return true;
 }
 
@@ -864,19 +1273,11 @@ bool uart_read_blocking(uart_channel_t channel, uint8_t *rx_buff,
   }
 
   // Check if usart channel is bus
-  if(IS_USART_CHANNEL(channel)) {
-  while (!READ_FIELD(USARTx_ISR[channel], USARTx_ISR_BUSY)) {
+  while (!READ_FIELD(UART_REG(channel, UART_REG_ISR), USARTx_ISR_BUSY)) {
     asm("nop");
     // tal_raise(flag, "USART channel is busy");
   }
-} else {
-  while (!READ_FIELD(UARTx_ISR[channel], UARTx_ISR_BUSY)) {
-    asm("nop");
-    // tal_raise(flag, "USART channel is busy");
-  }
-}
   // uart_busy[channel] = true;
-  
 
   // Receive the data byte by byte
   for (uint32_t i = 0; i < size; i++) {
@@ -890,3 +1291,177 @@ bool uart_read_blocking(uart_channel_t channel, uint8_t *rx_buff,
   // uart_busy[channel] = false;
   return true;
 }
+
+bool uart_rx_start(uart_channel_t channel, uint8_t *buffer, size_t size,
+                   uart_rx_callback_t idle_callback, void *context) {
+  if (!verify_transfer_parameters(channel, buffer, size) || channel >= UART_CHANNEL_COUNT) {
+    return false;
+  }
+  if ((size & (size - 1U)) != 0U || size > 0x80000000U) {
+    // tal_raise(flag, "RX buffer size must be a power of two");
+    return false;
+  }
+  if (uart_regs[channel].base == NULL) {
+    // tal_raise(flag, "UART channel not initialized");
+    return false;
+  }
+
+  uart_rx_ring_t ring = {
+      .buffer = buffer,
+      .mask = (uint32_t)size - 1U,
+      .head = 0,
+      .tail = 0,
+      .dropped = 0,
+      .idle_callback = idle_callback,
+      .context = context,
+  };
+  uart_rx_rings[channel] = ring;
+
+  // Interrupt when the RX FIFO is half full (8 bytes) and when the line goes idle, which
+  // also flushes whatever is left below the threshold at the end of a frame.
+  WRITE_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_RXFTCFG, 2U);
+  SET_FIELD(UART_REG(channel, UART_REG_CR3), USARTx_CR3_RXFTIE);
+  SET_WO_FIELD(UART_REG(channel, UART_REG_ICR), USARTx_ICR_IDLECF);
+  SET_FIELD(UART_REG(channel, UART_REG_CR1), USARTx_CR1_IDLEIE);
+  return true;
+}
+
+size_t uart_available(uart_channel_t channel) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT) {
+    return 0;
+  }
+  uart_rx_ring_t *ring = &uart_rx_rings[channel];
+  return ring->head - ring->tail;
+}
+
+size_t uart_rx_peek(uart_channel_t channel, const uint8_t **data) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT || data == NULL) {
+    return 0;
+  }
+  uart_rx_ring_t *ring = &uart_rx_rings[channel];
+  uint32_t tail = ring->tail;
+  uint32_t available = ring->head - tail;
+  uint32_t offset = tail & ring->mask;
+  uint32_t contiguous = (ring->mask + 1U) - offset;
+  *data = ring->buffer + offset;
+  return (available < contiguous) ? available : contiguous;
+}
+
+void uart_rx_consume(uart_channel_t channel, size_t count) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT) {
+    return;
+  }
+  uart_rx_ring_t *ring = &uart_rx_rings[channel];
+  uint32_t available = ring->head - ring->tail;
+  ring->tail += (count < available) ? (uint32_t)count : available;
+}
+
+size_t uart_read(uart_channel_t channel, uint8_t *rx_buff, size_t size) {
+  if (!verify_transfer_parameters(channel, rx_buff, size) || channel >= UART_CHANNEL_COUNT) {
+    return 0;
+  }
+  size_t total = 0;
+  while (total < size) {
+    const uint8_t *data;
+    size_t chunk = uart_rx_peek(channel, &data);
+    if (chunk == 0) {
+      break;
+    }
+    if (chunk > size - total) {
+      chunk = size - total;
+    }
+    for (size_t i = 0; i < chunk; i++) {
+      rx_buff[total + i] = data[i];
+    }
+    uart_rx_consume(channel, chunk);
+    total += chunk;
+  }
+  return total;
+}
+
+uint32_t uart_rx_dropped(uart_channel_t channel) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT) {
+    return 0;
+  }
+  return uart_rx_rings[channel].dropped;
+}
+
+bool uart_tx_submit(uart_channel_t channel, const uint8_t *buffer, size_t size,
+                    uart_tx_release_t release, void *context) {
+  if (!verify_transfer_parameters(channel, (uint8_t *)buffer, size) ||
+      channel >= UART_CHANNEL_COUNT) {
+    return false;
+  }
+  if (uart_regs[channel].base == NULL) {
+    // tal_raise(flag, "UART channel not initialized");
+    return false;
+  }
+
+  uart_tx_queue_t *tx = &uart_tx_queues[channel];
+  uint32_t primask = UART_IRQ_SAVE();
+  if (tx->count >= UART_TX_QUEUE_LEN) {
+    UART_IRQ_RESTORE(primask);
+    // tal_raise(flag, "UART TX queue is full");
+    return false;
+  }
+  uart_tx_desc_t desc = {
+      .data = buffer,
+      .size = size,
+      .release = release,
+      .context = context,
+  };
+  tx->queue[(tx->head + tx->count) % UART_TX_QUEUE_LEN] = desc;
+  tx->count++;
+  uart_tx_done_t done = {0};
+  uart_tx_kick(channel, &done);
+  UART_IRQ_RESTORE(primask);
+  uart_tx_release(channel, &done);
+  return true;
+}
+
+bool uart_tx_busy(uart_channel_t channel) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT) {
+    return false;
+  }
+  return uart_tx_queues[channel].count > 0;
+}
+
+bool uart_enable_stop_wakeup(uart_channel_t channel) {
+  if (channel == 0 || channel >= UART_CHANNEL_COUNT || uart_regs[channel].base == NULL) {
+    return false;
+  }
+  // The kernel clock has to survive (or be requested back) in Stop mode.
+  uart_clock_source_t source = uart_clock_sources[channel];
+  if (source != UART_CLOCK_HSI && source != UART_CLOCK_CSI && source != UART_CLOCK_LSE) {
+    // tal_raise(flag, "Stop mode wakeup needs an HSI, CSI or LSE kernel clock");
+    return false;
+  }
+
+  // Wake up on the start bit of the next frame. WUS can only be changed while UE = 0.
+  rw_reg32_t cr1 = UART_REG(channel, UART_REG_CR1);
+  rw_reg32_t cr3 = UART_REG(channel, UART_REG_CR3);
+  CLR_FIELD(cr1, USARTx_CR1_UE);
+  WRITE_FIELD(cr3, USARTx_CR3_WUS, 2U);
+  SET_FIELD(cr3, USARTx_CR3_WUFIE);
+  SET_FIELD(cr1, USARTx_CR1_UESM);
+  SET_FIELD(cr1, USARTx_CR1_UE);
+
+  // LPUART1 lives in D3, which keeps running autonomously while the CPU domain is stopped.
+  if (channel == LPUART1) {
+    SET_FIELD(RCC_D3AMR, RCC_D3AMR_LPUART1AMEN);
+  }
+  return true;
+}
+
+/**************************************************************************************************
+ * @section Interrupt Handlers
+ **************************************************************************************************/
+void usart1_irq_handler(void) { uart_irq_handler(UART1); }
+void usart2_irq_handler(void) { uart_irq_handler(UART2); }
+void usart3_irq_handler(void) { uart_irq_handler(UART3); }
+void uart4_irq_handler(void)  { uart_irq_handler(UART4); }
+void uart5_irq_handler(void)  { uart_irq_handler(UART5); }
+void usart6_irq_handler(void) { uart_irq_handler(UART6); }
+void uart7_irq_handler(void)  { uart_irq_handler(UART7); }
+void uart8_irq_handler(void)  { uart_irq_handler(UART8); }
+void lpuart_irq_handler(void) { uart_irq_handler(LPUART1); }
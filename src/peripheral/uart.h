@@ -27,9 +27,18 @@
 #include <stdint.h>
 
 /**************************************************************************************************
- * @section Data Structures
+ * @section Constants
  **************************************************************************************************/
-static const rw_reg32_t **UARTx_CRx;
+// Maximum number of buffers that can be pending in a channel's TX queue.
+#define UART_TX_QUEUE_LEN 8
+
+// Queued buffers at least this long (in bytes) are sent by the TX DMA stream, if the channel
+// has one. Shorter buffers are fed to the FIFO from the TX FIFO threshold interrupt, since
+// the DMA setup and completion interrupt cost more than the copy.
+#define UART_TX_DMA_THRESHOLD 64
+
+// uart_init() rejects baud rates that cannot be generated to within this error (in ppm).
+#define UART_BAUD_MAX_ERROR_PPM 10000
 
 /**************************************************************************************************
  * @section Type Definitions
@@ -43,6 +52,7 @@ typedef enum {
   UART6,
   UART7,
   UART8,
+  LPUART1,
   UART_CHANNEL_COUNT,
 } uart_channel_t;
 
@@ -58,19 +68,57 @@ typedef enum {
   UART_DATALENGTH_9,
 } uart_datalength_t;
 
+// Kernel clock sources, in RCC_D2CCIP2R/RCC_D3CCIPR encoding. USART1/6 share one selection,
+// and USART2/3 and UART4/5/7/8 share another, so uart_init() rejects a source other than the
+// one an initialized sibling channel uses. LPUART1 has its own. Only HSI, CSI and LSE keep
+// running in Stop mode.
+typedef enum {
+  UART_CLOCK_PCLK,
+  UART_CLOCK_PLL2Q,
+  UART_CLOCK_PLL3Q,
+  UART_CLOCK_HSI,
+  UART_CLOCK_CSI,
+  UART_CLOCK_LSE,
+} uart_clock_source_t;
+
 typedef struct {
   uart_channel_t channel;
   uart_parity_t parity;
   uart_datalength_t data_length;
-  uint32_t clk_freq;
+  uart_clock_source_t clk_source;
+  uint32_t clk_freq; // Frequency of the selected kernel clock in Hz, or 0 to read it from the RCC
   uint32_t baud_rate;
 } uart_config_t;
 
+// Baud rate generator settings, as computed by uart_baud_solve().
 typedef struct {
-  bool *busy;
+  uint32_t presc;       // PRESC register value
+  bool over8;           // 8x oversampling
+  uint32_t brr;         // BRR register value
+  uint32_t actual_baud; // Baud rate the settings produce
+  int32_t error_ppm;    // Deviation of actual_baud from the requested rate
+} uart_baud_t;
+
+// Context passed to the DMA callback given to uart_init().
+typedef struct {
+  bool *busy; // Reads: the channel's read-in-flight flag, already cleared. Writes: NULL
   uart_channel_t channel;
 } uart_context_t;
 
+/**
+ * @brief Called from interrupt context when the RX line goes idle, which marks the end of
+ * a frame. @p available is the number of bytes waiting in the RX ring buffer.
+ */
+typedef void (*uart_rx_callback_t)(uart_channel_t channel, size_t available, void *context);
+
+/**
+ * @brief Called when the driver is done with a buffer passed to uart_tx_submit(), from
+ * interrupt context or from uart_tx_submit() itself, with interrupts unmasked, if the buffer
+ * fit in the TX FIFO straight away. @p success is false if the DMA transfer sending it failed.
+ */
+typedef void (*uart_tx_release_t)(uart_channel_t channel, const uint8_t *buffer, bool success,
+                                  void *context);
+
 /**************************************************************************************************
  * @section Function Definitions
  **************************************************************************************************/
@@ -81,19 +129,61 @@ typedef struct {
  * @param usart_config: Config struct
  * @param dma_tx: TX DMA stream config
  * @param dma_rx: RX DMA stream config
- * @return true if initialization is successful, false otherwise.
+ * @return true if initialization is successful, false otherwise, including when the kernel
+ *         clock source differs from that of an initialized channel sharing its selection.
  */
 bool uart_init(uart_config_t *usart_config, dma_callback_t *callback,
                periph_dma_config_t *tx_stream, periph_dma_config_t *rx_stream);
 
+/**
+ * @brief Computes the prescaler, oversampling mode and BRR value that best approximate a
+ * baud rate. Pure function, does not touch the hardware.
+ * 16x oversampling is preferred over 8x, and smaller prescalers over larger ones, when
+ * they give the same error.
+ *
+ * @param clk_freq Kernel clock frequency in Hz.
+ * @param baud_rate Requested baud rate.
+ * @param result Receives the chosen settings and the resulting error.
+ * @return true if the rate can be generated at all (clk_freq / 8 >= baud_rate), false
+ *         otherwise.
+ */
+bool uart_baud_solve(uint32_t clk_freq, uint32_t baud_rate, uart_baud_t *result);
+
+/**
+ * @brief Gets the baud rate generator settings applied by uart_init().
+ *
+ * @param channel USART channel
+ * @param result Receives the settings, including the achieved rate and error.
+ * @return true if the channel has been initialized, false otherwise.
+ */
+bool uart_get_baud(uart_channel_t channel, uart_baud_t *result);
+
+/**
+ * @brief Keeps the channel receiving in Stop mode and wakes the CPU on the start bit of the
+ * next frame. Received bytes end up in the RX ring buffer as usual.
+ * Intended for LPUART1 running from LSE or HSI, so low rate links (heartbeats) stay up while
+ * the main clocks are gated. The channel must be initialized with an HSI, CSI or LSE kernel
+ * clock. LPUART1 does not support DMA, so pass NULL streams to uart_init() for it.
+ *
+ * @param channel USART channel
+ * @return true if Stop mode wakeup was enabled, false if the channel is not initialized or
+ *         its kernel clock stops in Stop mode.
+ */
+bool uart_enable_stop_wakeup(uart_channel_t channel);
+
 /**
  * @brief Sends data over the specified UART channel. Asyncronous function.
+ * The buffer is added to the channel's TX queue (see uart_tx_submit()), so writes are sent
+ * back to back and in order with buffers from uart_tx_submit(). The buffer must remain
+ * valid until the callback passed to uart_init() runs for it, which may happen before this
+ * returns if the buffer fit in the TX FIFO.
  *
  * @param channel USART channel
  * @param tx_buff Pointer to the data buffer to be transmitted.
  * @param size Number of bytes to transmit.
  *
- * @return true if data transmission is successful, false otherwise.
+ * @return true if the data was queued, false if the parameters are invalid or the
+ *         TX queue is full.
  */
 bool uart_write_async(uart_channel_t channel, uint8_t *tx_buff, uint32_t size);
 
@@ -130,5 +220,92 @@ bool uart_write_blocking(uart_channel_t channel, uint8_t *tx_buff,
 bool uart_read_blocking(uart_channel_t channel, uint8_t *rx_buff,
                         uint32_t size);
 
+/**
+ * @brief Starts interrupt-driven reception into a ring buffer.
+ * The RX FIFO is drained from the FIFO threshold and idle-line interrupts, so the CPU
+ * never waits on the UART. Bytes that arrive while the ring is full are dropped.
+ *
+ * @param channel USART channel
+ * @param buffer Ring buffer storage, owned by the driver until reset.
+ * @param size Size of the ring buffer. Must be a power of two.
+ * @param idle_callback Invoked on each idle-line (end of frame) event. May be NULL.
+ * @param context Passed to the callback.
+ * @return true if reception was started, false if the parameters are invalid.
+ */
+bool uart_rx_start(uart_channel_t channel, uint8_t *buffer, size_t size,
+                   uart_rx_callback_t idle_callback, void *context);
+
+/**
+ * @brief Gets the number of received bytes waiting in the RX ring buffer.
+ *
+ * @param channel USART channel
+ * @return Number of bytes that can be read without blocking.
+ */
+size_t uart_available(uart_channel_t channel);
+
+/**
+ * @brief Copies up to @p size received bytes out of the RX ring buffer. Non-blocking.
+ *
+ * @param channel USART channel
+ * @param rx_buff Destination buffer.
+ * @param size Maximum number of bytes to read.
+ * @return Number of bytes read.
+ */
+size_t uart_read(uart_channel_t channel, uint8_t *rx_buff, size_t size);
+
+/**
+ * @brief Zero-copy access to received data.
+ * Points @p data at the oldest unread byte in the RX ring buffer. The data stays valid
+ * until it is released with uart_rx_consume().
+ *
+ * @param channel USART channel
+ * @param data Set to the start of the contiguous readable region.
+ * @return Number of contiguous bytes at @p data (may be less than uart_available()
+ *         when the data wraps around the end of the ring).
+ */
+size_t uart_rx_peek(uart_channel_t channel, const uint8_t **data);
+
+/**
+ * @brief Releases bytes obtained through uart_rx_peek() back to the RX ring buffer.
+ *
+ * @param channel USART channel
+ * @param count Number of bytes to release.
+ */
+void uart_rx_consume(uart_channel_t channel, size_t count);
+
+/**
+ * @brief Gets the number of bytes lost to RX ring or hardware overruns.
+ *
+ * @param channel USART channel
+ */
+uint32_t uart_rx_dropped(uart_channel_t channel);
+
+/**
+ * @brief Queues a buffer for transmission without copying it. Non-blocking.
+ * Ownership of the buffer passes to the driver until @p release is called. Buffers are
+ * sent back to back in submission order: short ones are fed to the TX FIFO from the FIFO
+ * threshold interrupt, and ones of at least UART_TX_DMA_THRESHOLD bytes are handed to the
+ * channel's TX DMA stream when it has one. Do not mix with the other write functions on
+ * the same channel while the queue is busy.
+ *
+ * @param channel USART channel
+ * @param buffer Data to transmit. Must remain valid and unmodified until released.
+ * @param size Number of bytes to transmit.
+ * @param release Invoked once the buffer is no longer needed. May be NULL.
+ * @param context Passed to the release callback.
+ * @return true if the buffer was queued, false if the parameters are invalid or the
+ *         queue is full.
+ */
+bool uart_tx_submit(uart_channel_t channel, const uint8_t *buffer, size_t size,
+                    uart_tx_release_t release, void *context);
+
+/**
+ * @brief Checks whether a channel's TX queue still holds buffers.
+ *
+ * @param channel USART channel
+ * @return true if any submitted buffer has not been released yet.
+ */
+bool uart_tx_busy(uart_channel_t channel);
+
 static inline bool verify_transfer_parameters(uart_channel_t channel, uint8_t *buff,
                                        size_t size);
@@ -0,0 +1,271 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2024 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/util/frame.c
+ * @authors Charles Faisandier
+ * @brief Binary message framing (COBS + CRC-32) implementation.
+ */
+#include "frame.h"
+#ifndef FRAME_CRC_SOFTWARE
+#include "../internal/cm4.h"
+#include "../internal/interrupt.h"
+#include "../internal/mmio.h"
+#endif
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+// Reflected CRC-32 polynomial, for the software implementation.
+#define FRAME_CRC_POLY_REFLECTED 0xEDB88320U
+
+// Longest run of non-zero bytes a single COBS code byte can describe.
+#define FRAME_COBS_BLOCK 254U
+
+#ifndef FRAME_CRC_SOFTWARE
+// CRC_CR.REV_IN settings: bit reversal within each byte, or across the whole 32 bit word.
+#define FRAME_CRC_REV_IN_BYTE 1U
+#define FRAME_CRC_REV_IN_WORD 3U
+
+// Set while a context on the CM7 is using the CRC unit.
+static volatile bool frame_crc_busy = false;
+#endif
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+static void frame_decoder_reset(frame_decoder_t *decoder) {
+  decoder->len = 0;
+  decoder->remaining = 0;
+  decoder->pending_zero = false;
+  decoder->overflow = false;
+}
+
+static void frame_decoder_append(frame_decoder_t *decoder, uint8_t byte) {
+  if (decoder->len >= decoder->size) {
+    decoder->overflow = true;
+    return;
+  }
+  decoder->buffer[decoder->len++] = byte;
+}
+
+// Checks the frame held by the decoder once its delimiter has arrived. Returns the payload
+// length, or 0 if the frame is dropped.
+static size_t frame_decoder_finish(frame_decoder_t *decoder) {
+  size_t len = decoder->len;
+  bool truncated = (decoder->remaining != 0);
+  bool overflow = decoder->overflow;
+  frame_decoder_reset(decoder);
+
+  if (len == 0 && !truncated && !overflow) {
+    return 0; // Back to back delimiters, used as line fill or to force a resync.
+  }
+  if (truncated || overflow || len <= FRAME_CRC_SIZE) {
+    decoder->errors++;
+    return 0;
+  }
+  size_t payload_len = len - FRAME_CRC_SIZE;
+  const uint8_t *crc = decoder->buffer + payload_len;
+  uint32_t received = (uint32_t)crc[0] | ((uint32_t)crc[1] << 8) | ((uint32_t)crc[2] << 16) |
+                      ((uint32_t)crc[3] << 24);
+  if (received != frame_crc32(decoder->buffer, payload_len)) {
+    decoder->errors++;
+    return 0;
+  }
+  return payload_len;
+}
+
+static uint32_t frame_crc32_software(const uint8_t *data, size_t len) {
+  uint32_t crc = 0xFFFFFFFFU;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (FRAME_CRC_POLY_REFLECTED & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+#ifndef FRAME_CRC_SOFTWARE
+// Takes the CRC unit for the calling context. Fails if a context it preempted has it.
+static bool frame_crc_claim(void) {
+  uint32_t primask = irq_save();
+  bool free = !frame_crc_busy;
+  frame_crc_busy = true;
+  irq_restore(primask);
+  return free;
+}
+
+// Runs the CRC on the hardware unit, which the caller has claimed. Its reset polynomial is
+// the CRC-32 one. Whole words are fed with bit reversal across the word, which for little
+// endian data is the same as feeding each byte reflected, then the tail byte by byte.
+static uint32_t frame_crc32_hardware(const uint8_t *data, size_t len) {
+  SET_FIELD(RCC_AHB4ENR, RCC_AHB4ENR_CRCEN);
+  *CRC_POL = 0x04C11DB7U;
+  *CRC_INIT = 0xFFFFFFFFU;
+  WRITE_FIELD(CRC_CR, CRC_CR_POLYSIZE, 0U);
+  WRITE_FIELD(CRC_CR, CRC_CR_REV_IN, FRAME_CRC_REV_IN_WORD);
+  WRITE_FIELD(CRC_CR, CRC_CR_REV_OUT, 1U);
+  SET_FIELD(CRC_CR, CRC_CR_RESET);
+  size_t i = 0;
+  for (; i + 4U <= len; i += 4U) {
+    *CRC_DR = (uint32_t)data[i] | ((uint32_t)data[i + 1U] << 8) |
+              ((uint32_t)data[i + 2U] << 16) | ((uint32_t)data[i + 3U] << 24);
+  }
+  if (i < len) {
+    WRITE_FIELD(CRC_CR, CRC_CR_REV_IN, FRAME_CRC_REV_IN_BYTE);
+    volatile uint8_t *dr8 = (volatile uint8_t *)CRC_DR;
+    for (; i < len; i++) {
+      *dr8 = data[i];
+    }
+  }
+  return ~*CRC_DR;
+}
+#endif
+
+/**************************************************************************************************
+ * @section Public Function Implementations
+ **************************************************************************************************/
+uint32_t frame_crc32(const uint8_t *data, size_t len) {
+#ifndef FRAME_CRC_SOFTWARE
+  // The CRC unit belongs to the CM7. Interrupts stay enabled while it runs; a context that
+  // preempts the unit's user computes its CRC in software instead.
+  if (!cm4_is_current_core() && frame_crc_claim()) {
+    uint32_t crc = frame_crc32_hardware(data, len);
+    frame_crc_busy = false;
+    return crc;
+  }
+#endif
+  return frame_crc32_software(data, len);
+}
+
+size_t frame_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size) {
+  if (payload == NULL || len == 0 || out == NULL) {
+    return 0;
+  }
+  uint32_t crc = frame_crc32(payload, len);
+  uint8_t crc_bytes[FRAME_CRC_SIZE] = {
+      (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+
+  // Standard COBS: each block starts with a code byte holding the distance to the next zero
+  // (or 0xFF for a full block with no zero), which is filled in once the block is closed.
+  size_t code_pos = 0;
+  size_t pos = 1;
+  uint8_t code = 1;
+  size_t total = len + FRAME_CRC_SIZE;
+  if (out_size < 2) {
+    return 0;
+  }
+  for (size_t i = 0; i < total; i++) {
+    uint8_t byte = (i < len) ? payload[i] : crc_bytes[i - len];
+    if (byte != 0) {
+      if (pos >= out_size) {
+        return 0;
+      }
+      out[pos++] = byte;
+      code++;
+    }
+    if (byte == 0 || code == FRAME_COBS_BLOCK + 1U) {
+      out[code_pos] = code;
+      code_pos = pos;
+      // A full block is only followed by a new code byte if there is more data.
+      if (byte == 0 || i + 1 < total) {
+        if (pos >= out_size) {
+          return 0;
+        }
+        pos++;
+      }
+      code = 1;
+    }
+  }
+  if (code_pos < pos) {
+    out[code_pos] = code;
+  }
+  if (pos >= out_size) {
+    return 0;
+  }
+  out[pos++] = FRAME_DELIMITER;
+  return pos;
+}
+
+bool frame_send(uart_channel_t channel, const uint8_t *payload, size_t len, uint8_t *tx_buff,
+                size_t tx_size, uart_tx_release_t release, void *context) {
+  size_t encoded = frame_encode(payload, len, tx_buff, tx_size);
+  if (encoded == 0) {
+    return false;
+  }
+  return uart_tx_submit(channel, tx_buff, encoded, release, context);
+}
+
+void frame_decoder_init(frame_decoder_t *decoder, uint8_t *buffer, size_t size) {
+  if (decoder == NULL) {
+    return;
+  }
+  decoder->buffer = buffer;
+  decoder->size = (buffer != NULL) ? size : 0;
+  decoder->errors = 0;
+  frame_decoder_reset(decoder);
+}
+
+size_t frame_decode(frame_decoder_t *decoder, const uint8_t *data, size_t len,
+                    size_t *frame_len) {
+  if (frame_len != NULL) {
+    *frame_len = 0;
+  }
+  if (decoder == NULL || data == NULL) {
+    return 0;
+  }
+  for (size_t i = 0; i < len; i++) {
+    uint8_t byte = data[i];
+    if (byte == FRAME_DELIMITER) {
+      size_t payload_len = frame_decoder_finish(decoder);
+      if (payload_len > 0) {
+        if (frame_len != NULL) {
+          *frame_len = payload_len;
+        }
+        return i + 1;
+      }
+    } else if (decoder->remaining == 0) {
+      // Code byte. The zero implied by the previous block is only real if another block
+      // follows it, so it is written here rather than when that block ended.
+      if (decoder->pending_zero) {
+        frame_decoder_append(decoder, 0);
+      }
+      decoder->remaining = byte - 1U;
+      decoder->pending_zero = (byte != FRAME_COBS_BLOCK + 1U);
+    } else {
+      frame_decoder_append(decoder, byte);
+      decoder->remaining--;
+    }
+  }
+  return len;
+}
+
+size_t frame_poll(uart_channel_t channel, frame_decoder_t *decoder) {
+  if (decoder == NULL) {
+    return 0;
+  }
+  const uint8_t *data;
+  size_t available;
+  while ((available = uart_rx_peek(channel, &data)) > 0) {
+    size_t frame_len;
+    size_t consumed = frame_decode(decoder, data, available, &frame_len);
+    uart_rx_consume(channel, consumed);
+    if (frame_len > 0) {
+      return frame_len;
+    }
+  }
+  return 0;
+}
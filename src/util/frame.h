@@ -0,0 +1,141 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2024 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/util/frame.h
+ * @authors Charles Faisandier
+ * @brief Binary message framing (COBS + CRC-32) for UART links.
+ *
+ * Each frame is the COBS encoding of the payload followed by its CRC-32 (little endian),
+ * terminated by a single zero byte. COBS guarantees the delimiter never appears inside a
+ * frame, so a receiver that joins mid-stream or sees a corrupted byte resynchronizes at the
+ * next delimiter.
+ */
+#pragma once
+#include "../peripheral/uart.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+// Byte that terminates every frame.
+#define FRAME_DELIMITER 0x00U
+
+// Size of the CRC appended to each payload, in bytes.
+#define FRAME_CRC_SIZE 4U
+
+// Worst case encoded size of a payload of @p len bytes, including the CRC and delimiter.
+// COBS adds one byte per started 254 byte block.
+#define FRAME_ENCODED_MAX(len) \
+  ((len) + FRAME_CRC_SIZE + ((len) + FRAME_CRC_SIZE) / 254U + 2U)
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+/**
+ * @brief Incremental frame decoder state.
+ *
+ * Holds a partially received frame between calls, so data can be fed in whatever pieces
+ * it arrives in. Initialize with frame_decoder_init().
+ */
+typedef struct {
+  uint8_t *buffer;   // Decoded payload + CRC of the frame being received
+  size_t size;       // Capacity of buffer
+  size_t len;        // Bytes decoded so far
+  uint8_t remaining; // Data bytes left in the current COBS block, 0 if a code byte is next
+  bool pending_zero; // The current block ends in an implied zero
+  bool overflow;     // Frame did not fit in buffer, drop it at the delimiter
+  uint32_t errors;   // Frames dropped for bad CRC, bad encoding or overflow
+} frame_decoder_t;
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3, as used by zlib) of a buffer.
+ * Uses the hardware CRC unit on target builds. The unit is owned by the CM7: calls on the CM4,
+ * and calls that interrupt another user of the unit, use the bitwise software implementation.
+ * Nothing else may use the CRC unit. Define FRAME_CRC_SOFTWARE to always use software.
+ *
+ * @param data Data to checksum.
+ * @param len Number of bytes.
+ * @return The CRC.
+ */
+uint32_t frame_crc32(const uint8_t *data, size_t len);
+
+/**
+ * @brief Encodes a payload into a frame.
+ * Writes straight into @p out, so a DMA-able TX buffer can be filled and handed to the UART
+ * driver without another copy.
+ *
+ * @param payload Data to send.
+ * @param len Number of payload bytes. Must be non-zero.
+ * @param out Destination for the encoded frame.
+ * @param out_size Capacity of @p out. FRAME_ENCODED_MAX(len) is always enough.
+ * @return Encoded frame length including the delimiter, or 0 if @p out is too small.
+ */
+size_t frame_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size);
+
+/**
+ * @brief Encodes a payload into @p tx_buff and queues it on a UART channel.
+ * The buffer is owned by the UART driver until @p release is called (see uart_tx_submit()).
+ *
+ * @param channel UART channel
+ * @param payload Data to send. Only read during this call.
+ * @param len Number of payload bytes.
+ * @param tx_buff Buffer for the encoded frame.
+ * @param tx_size Capacity of @p tx_buff.
+ * @param release Invoked once the UART driver is done with @p tx_buff. May be NULL.
+ * @param context Passed to the release callback.
+ * @return true if the frame was queued, false if it does not fit or the TX queue is full.
+ */
+bool frame_send(uart_channel_t channel, const uint8_t *payload, size_t len, uint8_t *tx_buff,
+                size_t tx_size, uart_tx_release_t release, void *context);
+
+/**
+ * @brief Initializes a decoder.
+ *
+ * @param decoder Decoder state.
+ * @param buffer Storage for one decoded frame (payload + FRAME_CRC_SIZE bytes).
+ * @param size Capacity of @p buffer.
+ */
+void frame_decoder_init(frame_decoder_t *decoder, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Feeds received bytes to a decoder, stopping after the first complete frame.
+ *
+ * @param decoder Decoder state.
+ * @param data Received bytes.
+ * @param len Number of bytes available at @p data.
+ * @param frame_len Set to the payload length if a valid frame was completed (the payload is
+ *                  at the start of the decoder's buffer), 0 otherwise.
+ * @return Number of bytes consumed from @p data.
+ */
+size_t frame_decode(frame_decoder_t *decoder, const uint8_t *data, size_t len,
+                    size_t *frame_len);
+
+/**
+ * @brief Decodes data waiting in a channel's RX ring buffer (see uart_rx_start()).
+ * Works directly on the ring buffer and only consumes bytes up to the end of the first
+ * complete frame, so it can be called repeatedly until it returns 0.
+ *
+ * @param channel UART channel
+ * @param decoder Decoder state.
+ * @return Payload length of the next valid frame (at the start of the decoder's buffer), or
+ *         0 if no complete frame has been received yet.
+ */
+size_t frame_poll(uart_channel_t channel, frame_decoder_t *decoder);
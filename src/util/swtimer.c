@@ -0,0 +1,179 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/util/swtimer.c
+ * @authors Charles Faisandier
+ * @brief Hierarchical timer wheel implementation.
+ */
+#include "swtimer.h"
+#include "../internal/interrupt.h"
+#include <stddef.h>
+
+/**************************************************************************************************
+ * @section Private Definitions
+ **************************************************************************************************/
+#define SWTIMER_SLOT_MASK (SWTIMER_SLOTS - 1U)
+
+// Ticks covered by the whole wheel. Timers due later are parked in the top level.
+#define SWTIMER_SPAN (1U << (SWTIMER_SLOT_BITS * SWTIMER_LEVELS))
+
+// Interrupt masking hooks. The wheel is shared with the SysTick handler; host-side tests
+// override these.
+#ifndef SWTIMER_IRQ_SAVE
+#define SWTIMER_IRQ_SAVE() irq_save()
+#endif
+#ifndef SWTIMER_IRQ_RESTORE
+#define SWTIMER_IRQ_RESTORE(primask) irq_restore(primask)
+#endif
+
+// Head of the timer list of each slot.
+static swtimer_t *swtimer_wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+
+// Ticks since the wheel started. Wraps, as only differences with it are used.
+static uint32_t swtimer_ticks;
+
+/**************************************************************************************************
+ * @section Private Functions
+ **************************************************************************************************/
+static void swtimer_link(swtimer_t **slot, swtimer_t *timer) {
+  timer->next = *slot;
+  if (timer->next != NULL) {
+    timer->next->pprev = &timer->next;
+  }
+  timer->pprev = slot;
+  *slot = timer;
+}
+
+// Moves the timers of a slot to a local list. A timer stopped or restarted while it is on the
+// list unlinks itself from there.
+static void swtimer_detach(swtimer_t **slot, swtimer_t **list) {
+  *list = *slot;
+  *slot = NULL;
+  if (*list != NULL) {
+    (*list)->pprev = list;
+  }
+}
+
+static void swtimer_unlink(swtimer_t *timer) {
+  *timer->pprev = timer->next;
+  if (timer->next != NULL) {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+}
+
+// Links a timer into the slot its expiry falls in, at the lowest level whose span covers it.
+// Expects interrupts to be masked.
+static void swtimer_place(swtimer_t *timer) {
+  uint32_t delta = timer->expiry - swtimer_ticks;
+  uint32_t when = timer->expiry;
+  if (delta >= SWTIMER_SPAN) {
+    delta = SWTIMER_SPAN - 1U;
+    when = swtimer_ticks + delta;
+  }
+  uint32_t level = 0;
+  while (level < SWTIMER_LEVELS - 1U &&
+         delta >= (SWTIMER_SLOTS << (SWTIMER_SLOT_BITS * level))) {
+    level++;
+  }
+  uint32_t slot = (when >> (SWTIMER_SLOT_BITS * level)) & SWTIMER_SLOT_MASK;
+  swtimer_link(&swtimer_wheel[level][slot], timer);
+}
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+bool swtimer_start(swtimer_t *timer, uint32_t delay_ms, uint32_t period_ms,
+                   swtimer_callback_t callback, void *context) {
+  if (timer == NULL || callback == NULL) {
+    return false;
+  }
+  uint32_t primask = SWTIMER_IRQ_SAVE();
+  if (timer->pprev != NULL) {
+    swtimer_unlink(timer);
+  }
+  timer->expiry = swtimer_ticks + (delay_ms != 0 ? delay_ms : 1U);
+  timer->period = period_ms;
+  timer->callback = callback;
+  timer->context = context;
+  swtimer_place(timer);
+  SWTIMER_IRQ_RESTORE(primask);
+  return true;
+}
+
+void swtimer_stop(swtimer_t *timer) {
+  uint32_t primask = SWTIMER_IRQ_SAVE();
+  if (timer->pprev != NULL) {
+    swtimer_unlink(timer);
+  }
+  SWTIMER_IRQ_RESTORE(primask);
+}
+
+bool swtimer_active(const swtimer_t *timer) {
+  return timer->pprev != NULL;
+}
+
+void swtimer_tick(void) {
+  uint32_t primask = SWTIMER_IRQ_SAVE();
+  uint32_t now = ++swtimer_ticks;
+  SWTIMER_IRQ_RESTORE(primask);
+
+  // Each time a level completes a pass, spread the next slot of the level above over the
+  // levels below. Its timers are all due within the span of those levels. Interrupts are
+  // masked for one timer at a time.
+  for (uint32_t level = 1; level < SWTIMER_LEVELS; level++) {
+    uint32_t shift = SWTIMER_SLOT_BITS * level;
+    if ((now & ((1U << shift) - 1U)) != 0) {
+      break;
+    }
+    swtimer_t *pending;
+    primask = SWTIMER_IRQ_SAVE();
+    swtimer_detach(&swtimer_wheel[level][(now >> shift) & SWTIMER_SLOT_MASK], &pending);
+    SWTIMER_IRQ_RESTORE(primask);
+    bool more = true;
+    while (more) {
+      primask = SWTIMER_IRQ_SAVE();
+      swtimer_t *timer = pending;
+      more = (timer != NULL);
+      if (more) {
+        swtimer_unlink(timer);
+        swtimer_place(timer);
+      }
+      SWTIMER_IRQ_RESTORE(primask);
+    }
+  }
+
+  // Every timer in the current level 0 slot is due now. Move them to a local list, so a
+  // callback that stops another expired timer unlinks it from there.
+  swtimer_t *expired;
+  primask = SWTIMER_IRQ_SAVE();
+  swtimer_detach(&swtimer_wheel[0][now & SWTIMER_SLOT_MASK], &expired);
+  while (expired != NULL) {
+    swtimer_t *timer = expired;
+    swtimer_unlink(timer);
+    if (timer->period != 0) {
+      timer->expiry += timer->period;
+      swtimer_place(timer);
+    }
+    swtimer_callback_t callback = timer->callback;
+    void *context = timer->context;
+    SWTIMER_IRQ_RESTORE(primask);
+    callback(timer, context);
+    primask = SWTIMER_IRQ_SAVE();
+  }
+  SWTIMER_IRQ_RESTORE(primask);
+}
@@ -0,0 +1,106 @@
+/**
+ * This file is part of the Titan Flight Computer Project
+ * Copyright (c) 2025 UW SARP
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @file src/util/swtimer.h
+ * @authors Charles Faisandier
+ * @brief One-shot and periodic software timers on a hierarchical timer wheel.
+ *
+ * Timers are kept in SWTIMER_LEVELS wheels of SWTIMER_SLOTS slots each. Level 0 holds timers
+ * due within SWTIMER_SLOTS ticks, one slot per tick, and each level above covers
+ * SWTIMER_SLOTS times the span of the one below. Starting or stopping a timer links or unlinks
+ * it from one slot, and each tick runs one level 0 slot, so both are O(1). When a level 0 pass
+ * completes, the next slot of the level above is spread over the levels below (cascaded).
+ * Timers due beyond the top level are parked in it, and placed again when it cascades.
+ *
+ * The wheel advances once per SysTick tick (1 ms) from the SysTick handler, once time_init()
+ * has started it. SysTick runs at the lowest interrupt priority, so callbacks run in interrupt
+ * context below every peripheral interrupt: they can be preempted by any of them, but hold up
+ * the other timers and thread code, so they should be short and must not block. Timers are
+ * owned by the caller and must stay valid while they are running.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @section Constants
+ **************************************************************************************************/
+// Wheel geometry. Timers due within SWTIMER_SLOTS^SWTIMER_LEVELS ticks (~4.6 hours) never
+// need to be parked.
+#define SWTIMER_SLOT_BITS 6U
+#define SWTIMER_SLOTS (1U << SWTIMER_SLOT_BITS)
+#define SWTIMER_LEVELS 4U
+
+/**************************************************************************************************
+ * @section Type Definitions
+ **************************************************************************************************/
+typedef struct swtimer swtimer_t;
+
+/**
+ * @brief Called from the SysTick handler when a timer expires. A periodic timer has already
+ * been rearmed, so the callback may stop or restart it.
+ */
+typedef void (*swtimer_callback_t)(swtimer_t *timer, void *context);
+
+/** @brief Timer state. Zero-initialize (or stop) before the first use. */
+struct swtimer {
+  swtimer_t *next;    // Next timer in the same slot
+  swtimer_t **pprev;  // Link pointing at this timer, NULL while stopped
+  uint32_t expiry;    // Tick the timer is due at
+  uint32_t period;    // Ticks between expiries, 0 for a one-shot timer
+  swtimer_callback_t callback;
+  void *context;
+};
+
+/**************************************************************************************************
+ * @section Public Functions
+ **************************************************************************************************/
+/**
+ * @brief Starts a timer, or restarts it if it is running.
+ * Can be called from any context, including a timer callback.
+ *
+ * @param timer Timer to start.
+ * @param delay_ms Ticks (ms) until the first expiry. The tick in progress counts as one, so it
+ *        may come up to 1 ms early. 0 expires on the next tick, like 1.
+ * @param period_ms Time between later expiries, in ms, or 0 for a one-shot timer.
+ * @param callback Called on each expiry.
+ * @param context Passed to the callback.
+ * @return True on success, false if timer or callback is NULL.
+ */
+bool swtimer_start(swtimer_t *timer, uint32_t delay_ms, uint32_t period_ms,
+                   swtimer_callback_t callback, void *context);
+
+/**
+ * @brief Stops a timer. Does nothing if it is not running.
+ * Can be called from any context, including a timer callback.
+ *
+ * @param timer Timer to stop.
+ */
+void swtimer_stop(swtimer_t *timer);
+
+/**
+ * @brief Checks whether a timer is running.
+ *
+ * @param timer The timer.
+ * @return True if the timer will expire again.
+ */
+bool swtimer_active(const swtimer_t *timer);
+
+/**
+ * @brief Advances the wheel by one tick and runs the timers that expire.
+ * Called from the SysTick handler.
+ */
+void swtimer_tick(void);
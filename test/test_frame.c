@@ -0,0 +1,205 @@
+/**
+ * Host-side tests for the COBS + CRC-32 framing layer.
+ *
+ * Builds frame.c with the software CRC and a fake RX ring buffer standing in for the UART
+ * driver. Checks the CRC against the standard check value, round trips payloads of every
+ * awkward shape through the encoder and decoder, and checks that the decoder drops corrupted
+ * frames and resynchronizes on the next delimiter.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/util/frame.h"
+
+#include "test_harness.h"
+
+/**************************************************************************************************
+ * Fake UART driver
+ **************************************************************************************************/
+
+static uint8_t rx_ring[64];
+static size_t rx_head;
+static size_t rx_tail;
+
+bool uart_tx_submit(uart_channel_t channel, const uint8_t *buffer, size_t size,
+                    uart_tx_release_t release, void *context) {
+    (void)channel; (void)buffer; (void)size; (void)release; (void)context;
+    return true;
+}
+
+size_t uart_rx_peek(uart_channel_t channel, const uint8_t **data) {
+    (void)channel;
+    size_t offset = rx_tail % sizeof(rx_ring);
+    size_t contiguous = sizeof(rx_ring) - offset;
+    size_t available = rx_head - rx_tail;
+    *data = rx_ring + offset;
+    return available < contiguous ? available : contiguous;
+}
+
+void uart_rx_consume(uart_channel_t channel, size_t count) {
+    (void)channel;
+    rx_tail += count;
+}
+
+static void rx_push(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        rx_ring[rx_head++ % sizeof(rx_ring)] = data[i];
+    }
+}
+
+/**************************************************************************************************
+ * Helpers
+ **************************************************************************************************/
+
+// Payload shapes that exercise the COBS block boundaries.
+static void fill_payload(uint8_t *payload, size_t len, int shape) {
+    for (size_t i = 0; i < len; i++) {
+        switch (shape) {
+        case 0: payload[i] = 0x00; break;                       // All delimiters
+        case 1: payload[i] = 0xFF; break;                       // No zeros at all
+        case 2: payload[i] = (uint8_t)(i % 7 == 0 ? 0 : i);  break;  // Sparse zeros
+        default: payload[i] = (uint8_t)rand(); break;
+        }
+    }
+}
+
+/**************************************************************************************************
+ * Tests
+ **************************************************************************************************/
+
+static void test_crc(void) {
+    printf("  test_crc\n");
+    assert_check(frame_crc32((const uint8_t *)"123456789", 9) == 0xCBF43926U,
+                 "CRC-32 check value matches");
+    assert_check(frame_crc32(NULL, 0) == 0, "CRC of nothing is zero");
+}
+
+static void test_round_trip(void) {
+    static uint8_t payload[1100];
+    static uint8_t encoded[FRAME_ENCODED_MAX(sizeof(payload))];
+    static uint8_t decoded[sizeof(payload) + FRAME_CRC_SIZE];
+    static const size_t lengths[] = {1, 2, 253, 254, 255, 256, 507, 508, 509, 1000, 1100};
+    int bad_encoding = 0;
+    int bad_size = 0;
+    int bad_decode = 0;
+    printf("  test_round_trip\n");
+    for (int shape = 0; shape < 4; shape++) {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            size_t len = lengths[l];
+            fill_payload(payload, len, shape);
+            size_t n = frame_encode(payload, len, encoded, sizeof(encoded));
+            if (n == 0 || n > FRAME_ENCODED_MAX(len)) {
+                bad_size++;
+                continue;
+            }
+            for (size_t i = 0; i + 1 < n; i++) {
+                if (encoded[i] == FRAME_DELIMITER) {
+                    bad_encoding++;
+                }
+            }
+            if (encoded[n - 1] != FRAME_DELIMITER) {
+                bad_encoding++;
+            }
+
+            // Feed the frame one byte at a time, as it would trickle out of the RX ring.
+            frame_decoder_t decoder;
+            frame_decoder_init(&decoder, decoded, sizeof(decoded));
+            size_t frame_len = 0;
+            for (size_t i = 0; i < n && frame_len == 0; i++) {
+                frame_decode(&decoder, &encoded[i], 1, &frame_len);
+            }
+            if (frame_len != len || memcmp(decoded, payload, len) != 0 || decoder.errors != 0) {
+                bad_decode++;
+            }
+        }
+    }
+    assert_check(bad_size == 0, "encoded size stays within FRAME_ENCODED_MAX");
+    assert_check(bad_encoding == 0, "only the final byte is a delimiter");
+    assert_check(bad_decode == 0, "byte-by-byte decoding returns the original payload");
+}
+
+static void test_encode_limits(void) {
+    uint8_t payload[16] = {1, 2, 3};
+    uint8_t out[FRAME_ENCODED_MAX(16)];
+    printf("  test_encode_limits\n");
+    assert_check(frame_encode(payload, 0, out, sizeof(out)) == 0, "empty payload is rejected");
+    assert_check(frame_encode(payload, 16, out, FRAME_ENCODED_MAX(16) - 2) == 0,
+                 "too small output buffer is rejected");
+    assert_check(frame_encode(payload, 16, out, sizeof(out)) > 0, "exact worst case fits");
+}
+
+static void test_resync(void) {
+    uint8_t payload[32];
+    uint8_t frame_a[FRAME_ENCODED_MAX(32)];
+    uint8_t frame_b[FRAME_ENCODED_MAX(32)];
+    uint8_t decoded[32 + FRAME_CRC_SIZE];
+    printf("  test_resync\n");
+
+    fill_payload(payload, sizeof(payload), 3);
+    size_t na = frame_encode(payload, sizeof(payload), frame_a, sizeof(frame_a));
+    fill_payload(payload, sizeof(payload), 2);
+    size_t nb = frame_encode(payload, sizeof(payload), frame_b, sizeof(frame_b));
+
+    frame_decoder_t decoder;
+    frame_decoder_init(&decoder, decoded, sizeof(decoded));
+    frame_a[5] ^= 0x10; // Corrupt the first frame
+    size_t frame_len;
+    size_t used = frame_decode(&decoder, frame_a, na, &frame_len);
+    assert_check(used == na && frame_len == 0 && decoder.errors == 1,
+                 "corrupted frame is dropped and counted");
+    used = frame_decode(&decoder, frame_b, nb, &frame_len);
+    assert_check(frame_len == sizeof(payload) && memcmp(decoded, payload, frame_len) == 0,
+                 "next frame decodes after the delimiter");
+
+    // Join mid-stream: the tail of a frame is garbage, the next one is fine.
+    frame_decoder_init(&decoder, decoded, sizeof(decoded));
+    frame_decode(&decoder, frame_b + 7, nb - 7, &frame_len);
+    assert_check(frame_len == 0, "partial frame at start of stream is dropped");
+    frame_decode(&decoder, frame_b, nb, &frame_len);
+    assert_check(frame_len == sizeof(payload), "decoder is in sync after the partial frame");
+
+    // A frame longer than the decode buffer is dropped without writing past it.
+    uint8_t small[8];
+    frame_decoder_init(&decoder, small, sizeof(small));
+    frame_decode(&decoder, frame_b, nb, &frame_len);
+    assert_check(frame_len == 0 && decoder.errors == 1, "oversized frame is dropped");
+}
+
+static void test_poll(void) {
+    uint8_t payload[40];
+    uint8_t frame[FRAME_ENCODED_MAX(40)];
+    uint8_t decoded[40 + FRAME_CRC_SIZE];
+    printf("  test_poll\n");
+
+    fill_payload(payload, sizeof(payload), 2);
+    size_t n = frame_encode(payload, sizeof(payload), frame, sizeof(frame));
+    frame_decoder_t decoder;
+    frame_decoder_init(&decoder, decoded, sizeof(decoded));
+
+    // Two frames wrapping around the end of the ring, arriving in pieces.
+    rx_head = rx_tail = sizeof(rx_ring) - 10;
+    rx_push(frame, n / 2);
+    assert_check(frame_poll(UART1, &decoder) == 0, "half a frame is not reported");
+    rx_push(frame + n / 2, n - n / 2);
+    rx_push(frame, 3);
+    assert_check(frame_poll(UART1, &decoder) == sizeof(payload), "complete frame is reported");
+    assert_check(rx_head - rx_tail == 3, "bytes after the frame stay in the ring");
+    rx_push(frame + 3, n - 3);
+    assert_check(frame_poll(UART1, &decoder) == sizeof(payload) &&
+                     memcmp(decoded, payload, sizeof(payload)) == 0,
+                 "second frame decodes across the wrap");
+    assert_check(frame_poll(UART1, &decoder) == 0 && rx_head == rx_tail, "ring is drained");
+}
+
+int main(void) {
+    test_crc();
+    test_round_trip();
+    test_encode_limits();
+    test_resync();
+    test_poll();
+
+    return test_summary();
+}
@@ -0,0 +1,30 @@
+/**
+ * Assertion counting shared by the host-side tests.
+ *
+ * Each test prints one line per check and finishes with test_summary(), whose result is the
+ * process exit code.
+ */
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <stdio.h>
+
+static int total_asserts = 0;
+static int total_failures = 0;
+
+static void assert_check(int condition, const char *msg) {
+    total_asserts++;
+    if (!condition) {
+        total_failures++;
+    }
+    printf("    - %-66s %s\n", msg, condition ? "[OK]" : "[FAIL]");
+}
+
+// Prints the totals and returns 0 if every check passed, 1 otherwise.
+static int test_summary(void) {
+    printf("\nSummary: %d/%d assertions passed, %d failed.\n", total_asserts - total_failures,
+           total_asserts, total_failures);
+    return (total_failures == 0) ? 0 : 1;
+}
+
+#endif /* TEST_HARNESS_H */
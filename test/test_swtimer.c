@@ -0,0 +1,211 @@
+/**
+ * Host-side tests for the software timer wheel.
+ *
+ * Builds swtimer.c with interrupt masking stubbed out and drives swtimer_tick() by hand.
+ * Checks that one-shot and periodic timers fire on exactly the tick they are due at, across
+ * every level of the wheel, past its span and across the tick counter wrapping, and that
+ * timers can be stopped and restarted from their own and other timers' callbacks.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWTIMER_IRQ_SAVE() 0U
+#define SWTIMER_IRQ_RESTORE(primask) ((void)(primask))
+#include "../src/util/swtimer.c"
+
+#include "test_harness.h"
+
+/**************************************************************************************************
+ * Test helpers
+ **************************************************************************************************/
+
+// Counts expiries, and flags any that came on a tick other than the one due.
+typedef struct {
+    uint32_t fired;
+    bool late_or_early;
+    uint32_t next_due;
+    uint32_t period;
+} record_t;
+
+static void record_callback(swtimer_t *timer, void *context) {
+    (void)timer;
+    record_t *record = context;
+    if (swtimer_ticks != record->next_due) {
+        record->late_or_early = true;
+    }
+    record->fired++;
+    record->next_due += record->period;
+}
+
+static void reset_wheel(uint32_t ticks) {
+    memset(swtimer_wheel, 0, sizeof(swtimer_wheel));
+    swtimer_ticks = ticks;
+}
+
+static void run(uint32_t ticks) {
+    for (uint32_t i = 0; i < ticks; i++) {
+        swtimer_tick();
+    }
+}
+
+static bool wheel_empty(void) {
+    for (uint32_t level = 0; level < SWTIMER_LEVELS; level++) {
+        for (uint32_t slot = 0; slot < SWTIMER_SLOTS; slot++) {
+            if (swtimer_wheel[level][slot] != NULL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**************************************************************************************************
+ * Tests
+ **************************************************************************************************/
+
+static void test_one_shot(void) {
+    printf("One-shot timers:\n");
+    // One delay per level boundary, plus some past the span of the wheel.
+    const uint32_t delays[] = {1, 2, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 262145,
+                               SWTIMER_SPAN - 1U, SWTIMER_SPAN, SWTIMER_SPAN + 12345U,
+                               3U * SWTIMER_SPAN + 7U};
+    const uint32_t starts[] = {0, 1, 63, 100, 4095, 0xFFFFFF00U};
+    bool exact = true;
+    for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+        for (size_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++) {
+            reset_wheel(starts[s]);
+            swtimer_t timer = {0};
+            record_t record = {.next_due = starts[s] + delays[d]};
+            swtimer_start(&timer, delays[d], 0, record_callback, &record);
+            run(delays[d] + 200U);
+            exact = exact && record.fired == 1 && !record.late_or_early &&
+                    !swtimer_active(&timer) && wheel_empty();
+        }
+    }
+    assert_check(exact, "fires once, on its due tick, for every level and start");
+
+    reset_wheel(10);
+    swtimer_t timer = {0};
+    record_t record = {.next_due = 11};
+    swtimer_start(&timer, 0, 0, record_callback, &record);
+    run(5);
+    assert_check(record.fired == 1 && !record.late_or_early, "zero delay fires on the next tick");
+}
+
+static void test_periodic(void) {
+    printf("Periodic timers:\n");
+    reset_wheel(0xFFFFF000U); // Wraps partway through
+    swtimer_t fast = {0};
+    swtimer_t slow = {0};
+    record_t fast_record = {.next_due = 0xFFFFF000U + 3U, .period = 7};
+    record_t slow_record = {.next_due = 0xFFFFF000U + 5000U, .period = 5000};
+    swtimer_start(&fast, 3, 7, record_callback, &fast_record);
+    swtimer_start(&slow, 5000, 5000, record_callback, &slow_record);
+    run(100000);
+    assert_check(fast_record.fired == (100000 - 3) / 7 + 1 && !fast_record.late_or_early,
+                 "short period fires on every due tick");
+    assert_check(slow_record.fired == 100000 / 5000 && !slow_record.late_or_early,
+                 "long period fires on every due tick");
+    swtimer_stop(&fast);
+    swtimer_stop(&slow);
+    assert_check(!swtimer_active(&fast) && !swtimer_active(&slow) && wheel_empty(),
+                 "stopped timers leave the wheel");
+}
+
+static swtimer_t victim;
+static record_t victim_record;
+
+static void stop_self_callback(swtimer_t *timer, void *context) {
+    record_callback(timer, context);
+    if (((record_t *)context)->fired == 3) {
+        swtimer_stop(timer);
+    }
+}
+
+static void stop_victim_callback(swtimer_t *timer, void *context) {
+    (void)timer;
+    (void)context;
+    swtimer_stop(&victim);
+}
+
+static void restart_callback(swtimer_t *timer, void *context) {
+    record_t *record = context;
+    record_callback(timer, context);
+    if (record->fired < 4) {
+        record->next_due = swtimer_ticks + 100U;
+        swtimer_start(timer, 100, 0, restart_callback, context);
+    }
+}
+
+static void test_callbacks(void) {
+    printf("Changes from callbacks:\n");
+    reset_wheel(0);
+    swtimer_t periodic = {0};
+    record_t record = {.next_due = 10, .period = 10};
+    swtimer_start(&periodic, 10, 10, stop_self_callback, &record);
+    run(1000);
+    assert_check(record.fired == 3 && wheel_empty(), "periodic timer stops itself");
+
+    // Both due on the same tick. A slot runs newest first, so the stopper runs first.
+    reset_wheel(0);
+    swtimer_t stopper = {0};
+    victim_record = (record_t){.next_due = 50};
+    swtimer_start(&victim, 50, 0, record_callback, &victim_record);
+    swtimer_start(&stopper, 50, 0, stop_victim_callback, NULL);
+    run(100);
+    assert_check(victim_record.fired == 0 && wheel_empty(),
+                 "timer stopped by another expiring on the same tick");
+
+    reset_wheel(0);
+    swtimer_t one_shot = {0};
+    record = (record_t){.next_due = 30};
+    swtimer_start(&one_shot, 30, 0, restart_callback, &record);
+    run(1000);
+    assert_check(record.fired == 4 && !record.late_or_early && wheel_empty(),
+                 "one-shot timer restarts itself");
+
+    reset_wheel(0);
+    record = (record_t){.next_due = 500};
+    swtimer_start(&one_shot, 100, 0, record_callback, &record);
+    run(50);
+    record.next_due = 50U + 450U;
+    swtimer_start(&one_shot, 450, 0, record_callback, &record);
+    run(1000);
+    assert_check(record.fired == 1 && !record.late_or_early, "restart replaces the pending expiry");
+}
+
+static void test_random(void) {
+    printf("Random load:\n");
+    enum { TIMER_COUNT = 256 };
+    static swtimer_t timers[TIMER_COUNT];
+    static record_t records[TIMER_COUNT];
+    reset_wheel(0x12345678U);
+    memset(timers, 0, sizeof(timers));
+    srand(1);
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        uint32_t delay = 1U + (uint32_t)rand() % 300000U;
+        uint32_t period = (i % 2) ? 1U + (uint32_t)rand() % 70000U : 0U;
+        records[i] = (record_t){.next_due = swtimer_ticks + delay, .period = period};
+        swtimer_start(&timers[i], delay, period, record_callback, &records[i]);
+    }
+    run(400000);
+    bool exact = true;
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        exact = exact && records[i].fired > 0 && !records[i].late_or_early;
+        swtimer_stop(&timers[i]);
+    }
+    assert_check(exact, "every timer fires on each of its due ticks");
+    assert_check(wheel_empty(), "wheel is empty once all are stopped");
+}
+
+int main(void) {
+    test_one_shot();
+    test_periodic();
+    test_callbacks();
+    test_random();
+
+    return test_summary();
+}
@@ -0,0 +1,144 @@
+/**
+ * Host-side tests for the UART baud rate solver.
+ *
+ * Builds uart.c on the host and checks the PRESC/OVER8/BRR settings chosen by
+ * uart_baud_solve() against rates worked out by hand, then sweeps common kernel clocks
+ * and baud rates to check every solution reproduces the reported rate.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UART_IRQ_SAVE() 0U
+#define UART_IRQ_RESTORE(primask) ((void)(primask))
+#include "../src/peripheral/uart.c"
+
+#include "test_harness.h"
+
+/**************************************************************************************************
+ * Stubs for the rest of the driver's dependencies
+ **************************************************************************************************/
+
+void tal_set_mode(int pin, int mode) { (void)pin; (void)mode; }
+void tal_alternate_mode(int pin, int value) { (void)pin; (void)value; }
+bool tal_enable_clock(int pin) { (void)pin; return true; }
+bool dma_configure_stream(const dma_config_t *config) { (void)config; return true; }
+bool dma_start_transfer(dma_transfer_t *dma_transfer) { (void)dma_transfer; return true; }
+uint32_t clock_get_hz(clock_domain_t domain) { (void)domain; return 0; }
+
+/**************************************************************************************************
+ * Helpers
+ **************************************************************************************************/
+
+// Recovers USARTDIV from the register settings and computes the rate they produce.
+static double baud_from_registers(uint32_t clk_freq, const uart_baud_t *baud) {
+    uint32_t div = baud->over8 ? ((baud->brr & 0xFFF0U) | ((baud->brr & 0x7U) << 1))
+                               : baud->brr;
+    double ker_ck = (double)clk_freq / uart_presc_div[baud->presc];
+    return ker_ck * (baud->over8 ? 2.0 : 1.0) / div;
+}
+
+/**************************************************************************************************
+ * Tests
+ **************************************************************************************************/
+
+static void test_standard_rate(void) {
+    uart_baud_t baud;
+    printf("  test_standard_rate\n");
+    assert_check(uart_baud_solve(100000000, 115200, &baud), "115200 baud from 100 MHz solves");
+    assert_check(!baud.over8 && baud.presc == 0, "uses 16x oversampling, no prescaler");
+    assert_check(baud.brr == 868, "BRR is round(100 MHz / 115200)");
+    assert_check(baud.actual_baud == 115207, "reports the achieved rate");
+    assert_check(baud.error_ppm == 64, "reports the error in ppm");
+}
+
+static void test_high_rates(void) {
+    uart_baud_t baud;
+    printf("  test_high_rates\n");
+    assert_check(uart_baud_solve(96000000, 6000000, &baud), "6 Mbaud from 96 MHz solves");
+    assert_check(!baud.over8 && baud.brr == 16 && baud.error_ppm == 0,
+                 "6 Mbaud is exact with 16x oversampling");
+    assert_check(uart_baud_solve(96000000, 12000000, &baud), "12 Mbaud from 96 MHz solves");
+    assert_check(baud.over8 && baud.brr == 0x10 && baud.error_ppm == 0,
+                 "12 Mbaud switches to 8x oversampling");
+    assert_check(uart_baud_solve(100000000, 10000000, &baud), "10 Mbaud from 100 MHz solves");
+    assert_check(baud.over8 && baud.brr == 0x12 && baud.error_ppm == 0,
+                 "10 Mbaud uses the BRR[2:0] fraction with 8x oversampling");
+    assert_check(!uart_baud_solve(96000000, 12000001, &baud), "rates above clk / 8 fail");
+}
+
+static void test_low_rate_needs_prescaler(void) {
+    uart_baud_t baud;
+    printf("  test_low_rate_needs_prescaler\n");
+    assert_check(uart_baud_solve(200000000, 300, &baud), "300 baud from 200 MHz solves");
+    assert_check(baud.presc > 0, "prescaler brings USARTDIV into range");
+    assert_check(baud.brr <= 0xFFFF && abs(baud.error_ppm) < 100, "error stays small");
+    assert_check(!uart_baud_solve(550000000, 10, &baud), "rates below the divider range fail");
+}
+
+static void test_lpuart(void) {
+    uart_baud_t baud;
+    printf("  test_lpuart\n");
+    assert_check(uart_lpuart_baud_solve(32768, 9600, &baud), "9600 baud from LSE solves");
+    assert_check(baud.presc == 0 && baud.brr == 874, "BRR is round(256 * 32768 / 9600)");
+    assert_check(baud.error_ppm == -213, "reports the LSE rounding error");
+    assert_check(!uart_lpuart_baud_solve(32768, 19200, &baud), "19200 baud from LSE fails");
+    assert_check(uart_lpuart_baud_solve(100000000, 9600, &baud), "9600 baud from 100 MHz solves");
+    assert_check(baud.presc > 0 && baud.brr <= 0xFFFFF, "prescaler keeps BRR within 20 bits");
+}
+
+static void test_invalid_args(void) {
+    uart_baud_t baud;
+    printf("  test_invalid_args\n");
+    assert_check(!uart_baud_solve(100000000, 0, &baud), "zero baud rate fails");
+    assert_check(!uart_baud_solve(100000000, 115200, NULL), "NULL result fails");
+}
+
+static void test_sweep(void) {
+    static const uint32_t clocks[] = {8000000, 64000000, 100000000, 120000000, 137500000,
+                                      240000000};
+    static const uint32_t rates[] = {1200,   9600,    57600,   115200,  230400,   460800,
+                                     921600, 1000000, 2000000, 3000000, 4000000, 8000000};
+    int bad_regs = 0;
+    int bad_report = 0;
+    int bad_over8 = 0;
+    printf("  test_sweep\n");
+    for (size_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            uart_baud_t baud;
+            if (!uart_baud_solve(clocks[c], rates[r], &baud)) {
+                continue;
+            }
+            double actual = baud_from_registers(clocks[c], &baud);
+            double ppm = (actual - rates[r]) * 1e6 / rates[r];
+            if (baud.over8 && (baud.brr & 0x8U) != 0) {
+                bad_regs++;
+            }
+            if (ppm - baud.error_ppm > 1.0 || baud.error_ppm - ppm > 1.0 ||
+                (uint32_t)(actual + 0.5) != baud.actual_baud) {
+                bad_report++;
+            }
+            // 8x oversampling has less noise margin, so it must not replace an exact
+            // 16x solution.
+            if (clocks[c] % rates[r] == 0 && clocks[c] / rates[r] >= 16U &&
+                clocks[c] / rates[r] <= 0xFFFFU && (baud.over8 || baud.error_ppm != 0)) {
+                bad_over8++;
+            }
+        }
+    }
+    assert_check(bad_regs == 0, "8x oversampling always leaves BRR[3] clear");
+    assert_check(bad_report == 0, "reported rate and error match the register settings");
+    assert_check(bad_over8 == 0, "exact 16x solutions are never replaced by 8x ones");
+}
+
+int main(void) {
+    test_standard_rate();
+    test_high_rates();
+    test_low_rate_needs_prescaler();
+    test_lpuart();
+    test_invalid_args();
+    test_sweep();
+
+    return test_summary();
+}